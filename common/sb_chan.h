@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* zbus publishing with the publish latency of every channel.
+ *
+ * A channel defined with a struct sb_hist as its user data gets the time of
+ * each publish or notify added to it, in microseconds. That covers copying
+ * the message, running the listeners and queueing the subscribers, so it is
+ * the cost a publisher pays for everything attached to the channel.
+ */
+
+#ifndef SB_CHAN_H_
+#define SB_CHAN_H_
+
+#include <zephyr/kernel.h>
+#include <zephyr/zbus/zbus.h>
+#include <sb_stats.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline void sb_chan_latency(const struct zbus_channel *chan, uint32_t start_cyc)
+{
+	struct sb_hist *hist = zbus_chan_user_data(chan);
+
+	if (hist != NULL) {
+		sb_hist_add(hist, k_cyc_to_us_floor32(k_cycle_get_32() - start_cyc));
+	}
+}
+
+static inline int sb_chan_pub(const struct zbus_channel *chan, const void *msg,
+			      k_timeout_t timeout)
+{
+	uint32_t start_cyc = k_cycle_get_32();
+	int err = zbus_chan_pub(chan, msg, timeout);
+
+	sb_chan_latency(chan, start_cyc);
+
+	return err;
+}
+
+/* For messages changed in place between zbus_chan_claim() and
+ * zbus_chan_finish()
+ */
+static inline int sb_chan_notify(const struct zbus_channel *chan, k_timeout_t timeout)
+{
+	uint32_t start_cyc = k_cycle_get_32();
+	int err = zbus_chan_notify(chan, timeout);
+
+	sb_chan_latency(chan, start_cyc);
+
+	return err;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SB_CHAN_H_ */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Delta encoding of the score history carried in struct sb_score_adv.
+ *
+ * The broadcaster encodes every score change against the previous score,
+ * an observer that missed some changes walks them back from the score of a
+ * later report.
+ */
+
+#ifndef SB_HISTORY_H_
+#define SB_HISTORY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/sys/byteorder.h>
+#include <scoreboard_proto.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SB_HISTORY_DELTA_MIN (-16)
+#define SB_HISTORY_DELTA_MAX 15
+
+static inline uint8_t sb_history_entry(uint8_t field, int delta)
+{
+	return (field << 5) | (delta & 0x1f);
+}
+
+static inline uint8_t sb_history_field(uint8_t entry)
+{
+	return entry >> 5;
+}
+
+static inline int sb_history_delta(uint8_t entry)
+{
+	return (int)((int8_t)(entry << 3)) >> 3;
+}
+
+/**
+ * @brief Encode the change from one score to the next.
+ *
+ * @return History entry, SB_HISTORY_NONE if the change does not fit one.
+ */
+static inline uint8_t sb_history_encode(const struct sb_score *from, const struct sb_score *to)
+{
+	const int deltas[] = {
+		[SB_HISTORY_HOME_POINTS] = (int)sys_le16_to_cpu(to->home_points) -
+					   (int)sys_le16_to_cpu(from->home_points),
+		[SB_HISTORY_GUEST_POINTS] = (int)sys_le16_to_cpu(to->guest_points) -
+					    (int)sys_le16_to_cpu(from->guest_points),
+		[SB_HISTORY_HOME_SETS] = to->home_sets - from->home_sets,
+		[SB_HISTORY_GUEST_SETS] = to->guest_sets - from->guest_sets,
+		[SB_HISTORY_SERVING] = to->serving - from->serving,
+	};
+	uint8_t entry = SB_HISTORY_NONE;
+
+	for (uint8_t field = SB_HISTORY_HOME_POINTS; field <= SB_HISTORY_SERVING; field++) {
+		if (deltas[field] == 0) {
+			continue;
+		}
+
+		if ((entry != SB_HISTORY_NONE) || (deltas[field] < SB_HISTORY_DELTA_MIN) ||
+		    (deltas[field] > SB_HISTORY_DELTA_MAX)) {
+			return SB_HISTORY_NONE;
+		}
+
+		entry = sb_history_entry(field, deltas[field]);
+	}
+
+	return entry;
+}
+
+/**
+ * @brief Take a score back by one history entry.
+ *
+ * @param score Score after the change, the score before it on return.
+ * @param entry History entry of the change.
+ *
+ * @return false if the entry is SB_HISTORY_NONE, @p score is unchanged.
+ */
+static inline bool sb_history_undo(struct sb_score *score, uint8_t entry)
+{
+	int delta = sb_history_delta(entry);
+
+	switch (sb_history_field(entry)) {
+	case SB_HISTORY_HOME_POINTS:
+		score->home_points = sys_cpu_to_le16(sys_le16_to_cpu(score->home_points) - delta);
+		return true;
+	case SB_HISTORY_GUEST_POINTS:
+		score->guest_points = sys_cpu_to_le16(sys_le16_to_cpu(score->guest_points) - delta);
+		return true;
+	case SB_HISTORY_HOME_SETS:
+		score->home_sets -= delta;
+		return true;
+	case SB_HISTORY_GUEST_SETS:
+		score->guest_sets -= delta;
+		return true;
+	case SB_HISTORY_SERVING:
+		score->serving -= delta;
+		return true;
+	default:
+		return false;
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SB_HISTORY_H_ */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <string.h>
+#include "sb_stats.h"
+
+void sb_stats_print_counters(const struct shell *sh, struct sb_stats_counters *counters)
+{
+	int64_t now_ms = k_uptime_get();
+	int64_t elapsed_ms = now_ms - counters->last_ms;
+
+	shell_print(sh, "%-24s %10s %10s", "counter", "total", "per s");
+
+	for (size_t i = 0; i < counters->count; i++) {
+		uint32_t value = counters->values[i];
+		uint32_t delta = value - counters->last[i];
+
+		shell_print(sh, "%-24s %10u %10u", counters->names[i],
+			    value - counters->baseline[i],
+			    elapsed_ms > 0 ? (uint32_t)(delta * 1000LL / elapsed_ms) : 0);
+		counters->last[i] = value;
+	}
+
+	counters->last_ms = now_ms;
+}
+
+void sb_stats_print_hists(const struct shell *sh, const struct sb_stats_hists *hists)
+{
+	for (size_t i = 0; i < hists->count; i++) {
+		const struct sb_hist *hist = &hists->hists[i];
+		const struct sb_hist *base = &hists->baseline[i];
+		uint32_t count = hist->count - base->count;
+		uint32_t sum = hist->sum - base->sum;
+
+		shell_print(sh, "%s: count %u, avg %u, max since boot %u", hists->names[i],
+			    count, count ? sum / count : 0, hist->max);
+
+		for (uint32_t b = 0; b < SB_HIST_BUCKETS; b++) {
+			uint32_t n = hist->buckets[b] - base->buckets[b];
+
+			if (n == 0) {
+				continue;
+			}
+
+			shell_print(sh, "  < %6u: %u", (uint32_t)BIT(b), n);
+		}
+	}
+}
+
+void sb_stats_reset(struct sb_stats_counters *counters, struct sb_stats_hists *hists)
+{
+	memcpy(counters->baseline, counters->values, counters->count * sizeof(uint32_t));
+	memcpy(counters->last, counters->values, counters->count * sizeof(uint32_t));
+	counters->last_ms = k_uptime_get();
+
+	memcpy(hists->baseline, hists->hists, hists->count * sizeof(struct sb_hist));
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Runtime statistics shared by the scoreboard images.
+ *
+ * Every counter and histogram has exactly one writer context, an ISR or one
+ * thread. The hot path increment is then a plain load, add and store with no
+ * lock or interrupt masking. Readers (the shell) take a snapshot, 32-bit
+ * aligned loads are single copy atomic on Cortex-M. Resetting only moves the
+ * reader's baseline, the writer's counters are never written by the reader.
+ */
+
+#ifndef SB_STATS_H_
+#define SB_STATS_H_
+
+#include <stdint.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Log2 buckets, bucket n counts values in [2^(n-1), 2^n), bucket 0 counts 0 */
+#define SB_HIST_BUCKETS 16
+
+struct sb_hist {
+	uint32_t buckets[SB_HIST_BUCKETS];
+	uint32_t count;
+	uint32_t sum;
+	uint32_t max;
+};
+
+static inline void sb_stat_inc(uint32_t *counter)
+{
+	*counter += 1;
+}
+
+static inline void sb_stat_add(uint32_t *counter, uint32_t val)
+{
+	*counter += val;
+}
+
+static inline void sb_hist_add(struct sb_hist *hist, uint32_t val)
+{
+	uint32_t bucket = val ? 32 - __builtin_clz(val) : 0;
+
+	hist->buckets[MIN(bucket, SB_HIST_BUCKETS - 1)]++;
+	hist->count++;
+	hist->sum += val;
+	if (val > hist->max) {
+		hist->max = val;
+	}
+}
+
+/* A named group of counters, laid out as consecutive uint32_t */
+struct sb_stats_counters {
+	const char *const *names;
+	uint32_t *values;
+	uint32_t *baseline;
+	uint32_t *last;
+	size_t count;
+	int64_t last_ms;
+};
+
+/* Named histograms */
+struct sb_stats_hists {
+	const char *const *names;
+	struct sb_hist *hists;
+	struct sb_hist *baseline;
+	size_t count;
+};
+
+/**
+ * @brief Print counters with their rate since the previous print.
+ *
+ * @param sh Shell to print to.
+ * @param counters Counter group.
+ */
+void sb_stats_print_counters(const struct shell *sh, struct sb_stats_counters *counters);
+
+/**
+ * @brief Print histograms since the last reset.
+ *
+ * @param sh Shell to print to.
+ * @param hists Histogram group.
+ */
+void sb_stats_print_hists(const struct shell *sh, const struct sb_stats_hists *hists);
+
+/** @brief Start counting from the current values. */
+void sb_stats_reset(struct sb_stats_counters *counters, struct sb_stats_hists *hists);
+
+/* Helpers to build the counter and histogram structs and their name tables
+ * from one X macro list
+ */
+#define SB_STATS_NAME(_field) STRINGIFY(_field),
+#define SB_STATS_FIELD(_field) uint32_t _field;
+#define SB_STATS_HIST_FIELD(_field) struct sb_hist _field;
+
+/* Defines stats and stats_hists from the STATS_COUNTERS and STATS_HISTS
+ * lists of the application's stats.h, and the shell commands that print
+ * and reset them. SB_STATS_SHELL_CMDS(_name) adds those commands to a
+ * subcommand set.
+ */
+#define SB_STATS_SHELL_DEFINE(_name)						\
+	struct stats stats;							\
+	struct stats_hists stats_hists;						\
+										\
+	static const char *const _name##_counter_names[] = {			\
+		STATS_COUNTERS(SB_STATS_NAME)					\
+	};									\
+	static const char *const _name##_hist_names[] = {			\
+		STATS_HISTS(SB_STATS_NAME)					\
+	};									\
+										\
+	BUILD_ASSERT(sizeof(struct stats) ==					\
+		     ARRAY_SIZE(_name##_counter_names) * sizeof(uint32_t));	\
+	BUILD_ASSERT(sizeof(struct stats_hists) ==				\
+		     ARRAY_SIZE(_name##_hist_names) * sizeof(struct sb_hist));	\
+										\
+	static struct stats _name##_counters_baseline;				\
+	static struct stats _name##_counters_last;				\
+	static struct stats_hists _name##_hists_baseline;			\
+										\
+	static struct sb_stats_counters _name##_counters = {			\
+		.names = _name##_counter_names,					\
+		.values = (uint32_t *)&stats,					\
+		.baseline = (uint32_t *)&_name##_counters_baseline,		\
+		.last = (uint32_t *)&_name##_counters_last,			\
+		.count = ARRAY_SIZE(_name##_counter_names),			\
+	};									\
+										\
+	static struct sb_stats_hists _name##_hists = {				\
+		.names = _name##_hist_names,					\
+		.hists = (struct sb_hist *)&stats_hists,			\
+		.baseline = (struct sb_hist *)&_name##_hists_baseline,		\
+		.count = ARRAY_SIZE(_name##_hist_names),			\
+	};									\
+										\
+	static int _name##_cmd_stats(const struct shell *sh, size_t argc,	\
+				     char **argv)				\
+	{									\
+		sb_stats_print_counters(sh, &_name##_counters);			\
+		return 0;							\
+	}									\
+										\
+	static int _name##_cmd_hist(const struct shell *sh, size_t argc,	\
+				    char **argv)				\
+	{									\
+		sb_stats_print_hists(sh, &_name##_hists);			\
+		return 0;							\
+	}									\
+										\
+	static int _name##_cmd_reset(const struct shell *sh, size_t argc,	\
+				     char **argv)				\
+	{									\
+		sb_stats_reset(&_name##_counters, &_name##_hists);		\
+		return 0;							\
+	}
+
+#define SB_STATS_SHELL_CMDS(_name)						\
+	SHELL_CMD(stats, NULL, "Counters and rates since the last call",	\
+		  _name##_cmd_stats),						\
+	SHELL_CMD(hist, NULL, "Histograms, in the unit of their suffix",	\
+		  _name##_cmd_hist),						\
+	SHELL_CMD(reset, NULL, "Reset counters and histograms",			\
+		  _name##_cmd_reset)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SB_STATS_H_ */
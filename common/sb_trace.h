@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Tracing instrumentation points of the scoreboard pipelines.
+ *
+ * With CONFIG_TRACING each point emits a CTF named_event whose name is the
+ * stage, arg0 tells enter from exit and arg1 carries a stage specific value.
+ * scripts/sb_trace_analyze.py pairs them into per-stage latencies. Without
+ * tracing the points compile to nothing.
+ */
+
+#ifndef SB_TRACE_H_
+#define SB_TRACE_H_
+
+#include <stdint.h>
+
+#if defined(CONFIG_TRACING)
+#include <zephyr/tracing/tracing.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SB_TRACE_ENTER 0
+#define SB_TRACE_EXIT  1
+
+/* Stage names, at most 20 characters to fit the CTF event */
+#define SB_TRACE_UART_CB      "uart_cb"
+#define SB_TRACE_DISPATCH     "dispatch"
+#define SB_TRACE_ADV_UPDATE   "adv_update"
+#define SB_TRACE_SCAN_RECV    "scan_recv"
+#define SB_TRACE_DATA_CB      "data_cb"
+#define SB_TRACE_STRIP_UPDATE "strip_update"
+#define SB_TRACE_GATT_NOTIFY  "gatt_notify"
+#define SB_TRACE_GATT_RX      "gatt_rx"
+#define SB_TRACE_RELAY_RX     "relay_rx"
+#define SB_TRACE_RELAY_TX     "relay_tx"
+
+#if defined(CONFIG_TRACING)
+#define SB_TRACE_BEGIN(_stage, _arg) sys_trace_named_event(_stage, SB_TRACE_ENTER, (_arg))
+#define SB_TRACE_END(_stage, _arg)   sys_trace_named_event(_stage, SB_TRACE_EXIT, (_arg))
+#else
+#define SB_TRACE_BEGIN(_stage, _arg) do { ARG_UNUSED(_arg); } while (0)
+#define SB_TRACE_END(_stage, _arg)   do { ARG_UNUSED(_arg); } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SB_TRACE_H_ */
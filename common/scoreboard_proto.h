@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Over-the-air format shared by the scoreboard broadcaster and observer. */
+
+#ifndef SCOREBOARD_PROTO_H_
+#define SCOREBOARD_PROTO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/net/buf.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/toolchain.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Advertising set identifiers (SID) */
+#define SB_ADV_SID_SCORE            0   /* Compact score, struct sb_score */
+#define SB_ADV_SID_MATCH            1   /* TLV match record */
+#define SB_ADV_SID_GATT             2   /* Connectable, GATT scoreboard service */
+#define SB_ADV_SID_PAWR             3   /* Periodic advertising with responses */
+#define SB_ADV_SID_RELAY            4   /* Score re-advertised by a relay, struct sb_score_adv */
+#define SB_ADV_SID_CRDT             5   /* Score replicas of a broadcaster, for its peers */
+
+/* GATT scoreboard service. The score characteristic is read and notify and
+ * carries struct sb_score, the same bytes as the score advertising data.
+ */
+#define SB_GATT_SERVICE_UUID_VAL \
+	BT_UUID_128_ENCODE(0x5c0e0001, 0x7a1d, 0x4b8f, 0x9c3e, 0x2d6f1a4b8e01)
+#define SB_GATT_SCORE_UUID_VAL \
+	BT_UUID_128_ENCODE(0x5c0e0002, 0x7a1d, 0x4b8f, 0x9c3e, 0x2d6f1a4b8e01)
+
+/* Compact score, the manufacturer data of the SB_ADV_SID_SCORE set. Little
+ * endian on air. Points are 16 bit so that basketball scores fit.
+ */
+struct sb_score {
+	uint16_t company_id;
+	uint16_t home_points;
+	uint16_t guest_points;
+	uint8_t home_sets;
+	uint8_t guest_sets;
+	uint8_t serving;            /* Bit 0 home, bit 1 guest */
+} __packed;
+
+/* Score on the legacy advertising set, in the layout observers read before
+ * extended advertising. Points above 255 are sent as 255.
+ */
+struct sb_score_legacy {
+	uint16_t company_id;
+	uint8_t home_points;
+	uint8_t guest_points;
+	uint8_t home_sets;
+	uint8_t guest_sets;
+	uint8_t serving;
+} __packed;
+
+/* Score history, the changes that led to the advertised score, newest
+ * first: history[i] turned the score of seq - i - 1 into that of seq - i.
+ * Each byte is one change, the field in the upper three bits and the signed
+ * change of its value in the lower five, see sb_history.h. A change of
+ * several fields at once or by more than the five bits hold is sent as
+ * SB_HISTORY_NONE, and so are the entries before the first change. seq
+ * may skip values, their entries are SB_HISTORY_SAME.
+ */
+#define SB_SCORE_HISTORY_LEN 8
+
+#define SB_HISTORY_NONE         0
+#define SB_HISTORY_HOME_POINTS  1
+#define SB_HISTORY_GUEST_POINTS 2
+#define SB_HISTORY_HOME_SETS    3
+#define SB_HISTORY_GUEST_SETS   4
+#define SB_HISTORY_SERVING      5
+
+/* Entry of a sequence the score stayed the same over, a change by zero */
+#define SB_HISTORY_SAME         (SB_HISTORY_HOME_POINTS << 5)
+
+/* Score advertising data. The broadcaster counts score changes in seq and
+ * sends hops 0, a relay re-advertises the frame unchanged but for one more
+ * hop. epoch is drawn at random when the broadcaster starts, seq is only
+ * ordered within one epoch. Broadcasters that share a score take the
+ * highest epoch among them and count seq up by every step of the replicas,
+ * so that they advertise the same epoch and seq for the same score. Receivers that only know struct sb_score ignore
+ * the tail.
+ */
+struct sb_score_adv {
+	struct sb_score score;
+	uint16_t seq;
+	uint8_t epoch;
+	uint8_t hops;
+	uint8_t history[SB_SCORE_HISTORY_LEN];
+} __packed;
+
+/* Score in the PAwR subevents. seq counts score changes on the broadcaster,
+ * little endian on air. The score is shown at the anchor of the periodic
+ * event apply_in events after the one carrying it, 0 is this event.
+ */
+struct sb_pawr_score {
+	struct sb_score score;
+	uint16_t seq;
+	uint8_t apply_in;
+} __packed;
+
+/* PAwR response of a display, sent in the response slot of its display ID.
+ * seq is the last score sequence it shows, apply_late_us how long after the
+ * apply instant of that score its strip update started.
+ */
+struct sb_pawr_ack {
+	uint16_t company_id;
+	uint8_t display_id;
+	uint16_t seq;
+	uint16_t apply_late_us;
+} __packed;
+
+/* PAwR subevents. The score is in SB_PAWR_SUBEVENT_SCORE of every periodic
+ * event, and repeated in SB_PAWR_SUBEVENT_RETRY while a display lags behind.
+ */
+#define SB_PAWR_SUBEVENT_SCORE      0
+#define SB_PAWR_SUBEVENT_RETRY      1
+#define SB_PAWR_NUM_SUBEVENTS       2
+
+/* Score replicas gossiped between broadcasters on SB_ADV_SID_CRDT. Every
+ * voice input is a replica that only counts its own commands: points and
+ * sets go up by p and down by n, serving is the value with the highest
+ * (serving_clock, id). Merging takes the maximum of each field per replica,
+ * so hearing a state again never applies it twice and the order states
+ * arrive in does not matter. The score is the sum over the replicas.
+ * Little endian on air, after the company ID, SB_CRDT_RECORD_ID and the
+ * epoch of the shared score, merged by its maximum as well.
+ */
+#define SB_CRDT_RECORD_ID           0x43
+#define SB_CRDT_HEADER_LEN          4
+
+#define SB_CRDT_HOME_POINTS         0
+#define SB_CRDT_GUEST_POINTS        1
+#define SB_CRDT_HOME_SETS           2
+#define SB_CRDT_GUEST_SETS          3
+#define SB_CRDT_COUNTERS            4
+
+struct sb_crdt_replica {
+	uint8_t id;
+	uint16_t p[SB_CRDT_COUNTERS];
+	uint16_t n[SB_CRDT_COUNTERS];
+	uint16_t serving_clock;
+	uint8_t serving;
+} __packed;
+
+/* First byte after the company ID of the match record */
+#define SB_MATCH_RECORD_ID          0x4D
+
+/* Match record TLV types. Each TLV is type (1 byte), length (1 byte), value */
+#define SB_TLV_TEAM_HOME_NAME       0x01 /* UTF-8, not NUL terminated */
+#define SB_TLV_TEAM_GUEST_NAME      0x02 /* UTF-8, not NUL terminated */
+#define SB_TLV_TIMEOUTS             0x03 /* home (1 byte), guest (1 byte) */
+#define SB_TLV_FOULS                0x04 /* home (1 byte), guest (1 byte) */
+#define SB_TLV_PERIOD               0x05 /* period (1 byte) */
+#define SB_TLV_CLOCK                0x06 /* struct sb_clock_anchor */
+#define SB_TLV_TEAM_COLORS          0x07 /* home RGB (3 bytes), guest RGB (3 bytes) */
+#define SB_TLV_MESSAGE              0x08 /* UTF-8, not NUL terminated */
+
+#define SB_TEAM_NAME_MAX_LEN        16
+#define SB_MESSAGE_MAX_LEN          32
+
+/* Match clock anchor flags */
+#define SB_CLOCK_FLAG_RUNNING       BIT(0)
+#define SB_CLOCK_FLAG_COUNT_DOWN    BIT(1)
+
+/* Rate of a clock running in real time, in 1/1000 */
+#define SB_CLOCK_RATE_REALTIME      1000
+
+/* Clock anchor, little endian on air. The clock showed value_ds tenths of a
+ * second when the broadcaster uptime was anchor_ms, and advances by
+ * rate / SB_CLOCK_RATE_REALTIME tenths per tenth while running. It is only
+ * sent again on start, stop and adjust, observers interpolate in between.
+ */
+struct sb_clock_anchor {
+	uint8_t flags;
+	uint32_t value_ds;
+	uint32_t anchor_ms;
+	uint16_t rate;
+} __packed;
+
+/* Header in front of every TLV */
+#define SB_TLV_HDR_LEN              2
+
+struct sb_tlv {
+	uint8_t type;
+	uint8_t len;
+	const uint8_t *value;
+};
+
+/**
+ * @brief Append a TLV to an encode buffer.
+ *
+ * @param buf Encode buffer.
+ * @param size Size of @p buf.
+ * @param off Current write offset, advanced on success.
+ * @param type TLV type.
+ * @param value Value bytes.
+ * @param len Number of value bytes.
+ *
+ * @return true if the TLV fitted, false otherwise.
+ */
+static inline bool sb_tlv_put(uint8_t *buf, size_t size, size_t *off,
+			      uint8_t type, const void *value, uint8_t len)
+{
+	if (*off + SB_TLV_HDR_LEN + len > size) {
+		return false;
+	}
+
+	buf[(*off)++] = type;
+	buf[(*off)++] = len;
+	memcpy(&buf[*off], value, len);
+	*off += len;
+
+	return true;
+}
+
+/**
+ * @brief Pull the next TLV from a buffer without copying it.
+ *
+ * @p tlv points into the buffer data, which must outlive its use. Decoding
+ * stops at the first truncated TLV.
+ *
+ * @param buf Buffer positioned at a TLV header.
+ * @param tlv Decoded TLV.
+ *
+ * @return true if a complete TLV was pulled, false at the end of the data.
+ */
+static inline bool sb_tlv_next(struct net_buf_simple *buf, struct sb_tlv *tlv)
+{
+	if (buf->len < SB_TLV_HDR_LEN) {
+		return false;
+	}
+
+	tlv->type = buf->data[0];
+	tlv->len = buf->data[1];
+	if (buf->len < SB_TLV_HDR_LEN + tlv->len) {
+		return false;
+	}
+
+	net_buf_simple_pull(buf, SB_TLV_HDR_LEN);
+	tlv->value = net_buf_simple_pull_mem(buf, tlv->len);
+
+	return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCOREBOARD_PROTO_H_ */
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/zbus/zbus.h>
+#include <scoreboard_proto.h>
+#include "channels.h"
+#include "stats.h"
+
+#define COMPANY_ID_CODE 0x0059 // Nordic BLE ID
+
+/* Listeners in main.c */
+ZBUS_OBS_DECLARE(dispatch_lis, adv_payload_lis);
+
+ZBUS_CHAN_DEFINE(voice_cmd_chan, struct voice_cmd, NULL, &stats_hists.voice_cmd_pub_us,
+		 ZBUS_OBSERVERS(dispatch_lis), ZBUS_MSG_INIT(0));
+
+ZBUS_CHAN_DEFINE(score_chan, struct sb_score, NULL, &stats_hists.score_pub_us,
+		 ZBUS_OBSERVERS(adv_payload_lis), ZBUS_MSG_INIT(.company_id = COMPANY_ID_CODE));
+
+ZBUS_CHAN_DEFINE(adv_payload_chan, struct sb_score_adv, NULL, &stats_hists.adv_payload_pub_us,
+		 ZBUS_OBSERVERS_EMPTY, ZBUS_MSG_INIT(.score = {.company_id = COMPANY_ID_CODE}));
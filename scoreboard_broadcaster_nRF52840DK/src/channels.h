@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* zbus channels between the voice input, the score and the radio.
+ *
+ * voice_cmd_chan    struct voice_cmd, a command frame that passed the
+ *                   header and duplicate checks, published by thread0
+ * score_chan        struct sb_score, the merged score, published when it
+ *                   changed
+ * adv_payload_chan  struct sb_score_adv, the score with its sequence and
+ *                   history as advertised, published for every score
+ *
+ * The dispatch listens to voice_cmd_chan and the payload is built by a
+ * listener of score_chan, both run in thread0. Radio paths and other
+ * consumers attach to a channel with zbus_chan_add_obs() at init. Every
+ * channel keeps its publish latency in a histogram of the same name.
+ */
+
+#ifndef CHANNELS_H_
+#define CHANNELS_H_
+
+#include <stdint.h>
+#include <zephyr/zbus/zbus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct voice_cmd {
+	uint8_t source; /* Voice input, index in voice_uarts */
+	uint8_t cmd;    /* Command word ID */
+	uint8_t seq;    /* msgSeq of the frame */
+};
+
+ZBUS_CHAN_DECLARE(voice_cmd_chan, score_chan, adv_payload_chan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHANNELS_H_ */
@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Score as a state based CRDT.
+ *
+ * Every voice input is a replica that only records its own commands: a
+ * grow-only counter for the steps up (p) and one for the steps down (n) of
+ * each points and sets field, and a last writer wins register for serving.
+ * A command is applied to the merged score with score_apply_cmd() and the
+ * change it makes becomes steps of the replica, so saturation and reset
+ * keep their rules. A reset is steps down by the current values, points a
+ * concurrent replica adds meanwhile survive it.
+ *
+ * The merged score is the sum of p - n over the replicas, clamped to the
+ * range of each field, and serving is the value written with the highest
+ * (serving_clock, id). Replicas of peer broadcasters are merged by taking
+ * the maximum of each field, which is commutative, associative and
+ * idempotent: a state heard twice or out of order changes nothing, and
+ * every broadcaster that heard the same replicas shows the same score.
+ *
+ * The local replicas start over from zero after a restart, while peers
+ * still hold them with the counts from before it. Until crdt_join_end(),
+ * before the first local command, a peer's copy of a local replica is
+ * adopted, so that the counts go on from where they were.
+ *
+ * The score advertised is numbered by crdt_seq(), the count of all steps
+ * and serving changes over the replicas, within the epoch of the shared
+ * score, the highest drawn by a broadcaster. Both only grow by the merge,
+ * so broadcasters that heard the same replicas number a score the same.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include <scoreboard_proto.h>
+#include "crdt.h"
+#include "score.h"
+
+#define COMPANY_ID_CODE 0x0059 // Nordic BLE ID
+
+static struct sb_crdt_replica replicas[CONFIG_SCOREBOARD_CRDT_REPLICAS];
+static uint8_t replica_count;
+
+/* IDs of the replicas of this broadcaster's voice inputs */
+static uint8_t local_first;
+static uint8_t local_count;
+
+/* Peers' copies of the local replicas are adopted until the first command */
+static bool joining;
+
+static uint8_t epoch;
+
+/* Replicas are written and merged by thread0, peer.c encodes them */
+static struct k_spinlock crdt_lock;
+
+static struct sb_crdt_replica *find_locked(uint8_t id, bool add)
+{
+	struct sb_crdt_replica *r;
+
+	for (uint8_t i = 0; i < replica_count; i++) {
+		if (replicas[i].id == id) {
+			return &replicas[i];
+		}
+	}
+
+	if (!add || (replica_count == ARRAY_SIZE(replicas))) {
+		return NULL;
+	}
+
+	r = &replicas[replica_count++];
+	memset(r, 0, sizeof(*r));
+	r->id = id;
+
+	return r;
+}
+
+/* Sum of p - n of each counter over the replicas */
+static void sums_locked(int32_t sums[SB_CRDT_COUNTERS])
+{
+	for (int f = 0; f < SB_CRDT_COUNTERS; f++) {
+		sums[f] = 0;
+		for (uint8_t i = 0; i < replica_count; i++) {
+			sums[f] += (int32_t)sys_le16_to_cpu(replicas[i].p[f]) -
+				   (int32_t)sys_le16_to_cpu(replicas[i].n[f]);
+		}
+	}
+}
+
+static void score_locked(struct sb_score *score)
+{
+	const struct sb_crdt_replica *serving = NULL;
+	int32_t sums[SB_CRDT_COUNTERS];
+
+	sums_locked(sums);
+
+	score->home_points = sys_cpu_to_le16(CLAMP(sums[SB_CRDT_HOME_POINTS], 0,
+						   CONFIG_SCOREBOARD_POINTS_MAX));
+	score->guest_points = sys_cpu_to_le16(CLAMP(sums[SB_CRDT_GUEST_POINTS], 0,
+						    CONFIG_SCOREBOARD_POINTS_MAX));
+	score->home_sets = CLAMP(sums[SB_CRDT_HOME_SETS], 0, SCORE_SETS_MAX);
+	score->guest_sets = CLAMP(sums[SB_CRDT_GUEST_SETS], 0, SCORE_SETS_MAX);
+
+	for (uint8_t i = 0; i < replica_count; i++) {
+		const struct sb_crdt_replica *r = &replicas[i];
+		uint16_t clock = sys_le16_to_cpu(r->serving_clock);
+
+		if ((clock == 0) || ((serving != NULL) &&
+		    ((clock < sys_le16_to_cpu(serving->serving_clock)) ||
+		     ((clock == sys_le16_to_cpu(serving->serving_clock)) &&
+		      (r->id < serving->id))))) {
+			continue;
+		}
+		serving = r;
+	}
+
+	score->serving = (serving != NULL) ? serving->serving : 0;
+}
+
+static void step_locked(struct sb_crdt_replica *r, int f, int32_t delta)
+{
+	if (delta > 0) {
+		r->p[f] = sys_cpu_to_le16(sys_le16_to_cpu(r->p[f]) + delta);
+	} else if (delta < 0) {
+		r->n[f] = sys_cpu_to_le16(sys_le16_to_cpu(r->n[f]) - delta);
+	}
+}
+
+static void serve_locked(struct sb_crdt_replica *r, uint8_t serving)
+{
+	uint16_t clock = 0;
+
+	for (uint8_t i = 0; i < replica_count; i++) {
+		clock = MAX(clock, sys_le16_to_cpu(replicas[i].serving_clock));
+	}
+
+	r->serving_clock = sys_cpu_to_le16(clock + 1);
+	r->serving = serving;
+}
+
+int crdt_init(uint8_t first_id, uint8_t count, uint8_t first_epoch)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+	int err = 0;
+
+	local_first = first_id;
+	local_count = count;
+	joining = true;
+	epoch = first_epoch;
+	for (uint8_t i = 0; i < count; i++) {
+		if (find_locked(first_id + i, true) == NULL) {
+			err = -ENOMEM;
+			break;
+		}
+	}
+	k_spin_unlock(&crdt_lock, key);
+
+	return err;
+}
+
+void crdt_apply_cmd(uint8_t id, uint8_t cmd)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+	struct sb_crdt_replica *r = find_locked(id, false);
+	struct sb_score view, next;
+	int32_t sums[SB_CRDT_COUNTERS];
+	int32_t values[SB_CRDT_COUNTERS];
+
+	if (r == NULL) {
+		k_spin_unlock(&crdt_lock, key);
+		return;
+	}
+
+	score_locked(&view);
+	next = view;
+	if (!score_apply_cmd(&next, cmd)) {
+		k_spin_unlock(&crdt_lock, key);
+		return;
+	}
+
+	/* A changed field is stepped from its raw sum, which is off the
+	 * shown value when concurrent steps down went below zero
+	 */
+	sums_locked(sums);
+	values[SB_CRDT_HOME_POINTS] = sys_le16_to_cpu(next.home_points);
+	values[SB_CRDT_GUEST_POINTS] = sys_le16_to_cpu(next.guest_points);
+	values[SB_CRDT_HOME_SETS] = next.home_sets;
+	values[SB_CRDT_GUEST_SETS] = next.guest_sets;
+
+	for (int f = 0; f < SB_CRDT_COUNTERS; f++) {
+		int32_t shown = CLAMP(sums[f], 0, (f < SB_CRDT_HOME_SETS) ?
+					   CONFIG_SCOREBOARD_POINTS_MAX : SCORE_SETS_MAX);
+
+		if (values[f] != shown) {
+			step_locked(r, f, values[f] - sums[f]);
+		}
+	}
+
+	if (next.serving != view.serving) {
+		serve_locked(r, next.serving);
+	}
+	k_spin_unlock(&crdt_lock, key);
+}
+
+void crdt_apply_change(uint8_t id, const struct sb_score *from, const struct sb_score *to)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+	struct sb_crdt_replica *r = find_locked(id, false);
+
+	if (r == NULL) {
+		k_spin_unlock(&crdt_lock, key);
+		return;
+	}
+
+	step_locked(r, SB_CRDT_HOME_POINTS, (int32_t)sys_le16_to_cpu(to->home_points) -
+					    (int32_t)sys_le16_to_cpu(from->home_points));
+	step_locked(r, SB_CRDT_GUEST_POINTS, (int32_t)sys_le16_to_cpu(to->guest_points) -
+					     (int32_t)sys_le16_to_cpu(from->guest_points));
+	step_locked(r, SB_CRDT_HOME_SETS, (int32_t)to->home_sets - from->home_sets);
+	step_locked(r, SB_CRDT_GUEST_SETS, (int32_t)to->guest_sets - from->guest_sets);
+
+	if (to->serving != from->serving) {
+		serve_locked(r, to->serving);
+	}
+	k_spin_unlock(&crdt_lock, key);
+}
+
+bool crdt_replica_max(struct sb_crdt_replica *into, const struct sb_crdt_replica *from)
+{
+	bool grew = false;
+
+	for (int f = 0; f < SB_CRDT_COUNTERS; f++) {
+		if (sys_le16_to_cpu(from->p[f]) > sys_le16_to_cpu(into->p[f])) {
+			into->p[f] = from->p[f];
+			grew = true;
+		}
+		if (sys_le16_to_cpu(from->n[f]) > sys_le16_to_cpu(into->n[f])) {
+			into->n[f] = from->n[f];
+			grew = true;
+		}
+	}
+
+	if (sys_le16_to_cpu(from->serving_clock) > sys_le16_to_cpu(into->serving_clock)) {
+		into->serving_clock = from->serving_clock;
+		into->serving = from->serving;
+		grew = true;
+	}
+
+	return grew;
+}
+
+int crdt_merge(const struct sb_crdt_replica *remote)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+	struct sb_crdt_replica *r;
+	struct sb_crdt_replica local;
+	int ret;
+
+	/* Only this broadcaster writes its own replicas, peers pass them back.
+	 * Once it wrote them since the restart, a copy ahead of the local one
+	 * was written by a peer with the same IDs and is never merged.
+	 */
+	if ((remote->id >= local_first) && (remote->id < local_first + local_count)) {
+		r = find_locked(remote->id, false);
+		if (joining) {
+			ret = crdt_replica_max(r, remote) ? 1 : 0;
+		} else {
+			local = *r;
+			ret = crdt_replica_max(&local, remote) ? -EPERM : 0;
+		}
+		k_spin_unlock(&crdt_lock, key);
+		return ret;
+	}
+
+	r = find_locked(remote->id, true);
+	if (r == NULL) {
+		ret = -ENOMEM;
+	} else {
+		ret = crdt_replica_max(r, remote) ? 1 : 0;
+	}
+	k_spin_unlock(&crdt_lock, key);
+
+	return ret;
+}
+
+bool crdt_merge_epoch(uint8_t remote)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+	bool grew = remote > epoch;
+
+	epoch = MAX(epoch, remote);
+	k_spin_unlock(&crdt_lock, key);
+
+	return grew;
+}
+
+void crdt_join_end(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+
+	joining = false;
+	k_spin_unlock(&crdt_lock, key);
+}
+
+void crdt_score(struct sb_score *score)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+
+	score_locked(score);
+	k_spin_unlock(&crdt_lock, key);
+}
+
+uint8_t crdt_epoch(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+	uint8_t e = epoch;
+
+	k_spin_unlock(&crdt_lock, key);
+
+	return e;
+}
+
+uint16_t crdt_seq(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+	uint16_t seq = 0;
+
+	for (uint8_t i = 0; i < replica_count; i++) {
+		for (int f = 0; f < SB_CRDT_COUNTERS; f++) {
+			seq += sys_le16_to_cpu(replicas[i].p[f]) + sys_le16_to_cpu(replicas[i].n[f]);
+		}
+		seq += sys_le16_to_cpu(replicas[i].serving_clock);
+	}
+	k_spin_unlock(&crdt_lock, key);
+
+	return seq;
+}
+
+size_t crdt_encode(uint8_t *buf, size_t size)
+{
+	k_spinlock_key_t key = k_spin_lock(&crdt_lock);
+	size_t len = SB_CRDT_HEADER_LEN + replica_count * sizeof(struct sb_crdt_replica);
+
+	if (size < len) {
+		k_spin_unlock(&crdt_lock, key);
+		return 0;
+	}
+
+	sys_put_le16(COMPANY_ID_CODE, buf);
+	buf[2] = SB_CRDT_RECORD_ID;
+	buf[3] = epoch;
+	memcpy(&buf[SB_CRDT_HEADER_LEN], replicas, replica_count * sizeof(struct sb_crdt_replica));
+	k_spin_unlock(&crdt_lock, key);
+
+	return len;
+}
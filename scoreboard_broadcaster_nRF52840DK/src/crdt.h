@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef CRDT_H_
+#define CRDT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <scoreboard_proto.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the local replicas, before any peer is merged.
+ *
+ * @param first_id ID of the first local replica.
+ * @param count Number of local replicas, IDs first_id to first_id + count - 1.
+ * @param first_epoch Epoch drawn at this start, until a peer's is higher.
+ *
+ * @return 0 on success, -ENOMEM if they do not fit CONFIG_SCOREBOARD_CRDT_REPLICAS.
+ */
+int crdt_init(uint8_t first_id, uint8_t count, uint8_t first_epoch);
+
+/**
+ * @brief Apply a command word as operations of a local replica.
+ *
+ * The command changes the merged score by the rules of score_apply_cmd(),
+ * the replica records that change. Called from thread0.
+ *
+ * @param id Local replica ID.
+ * @param cmd Command word ID.
+ */
+void crdt_apply_cmd(uint8_t id, uint8_t cmd);
+
+/**
+ * @brief Record a change of the score as operations of a local replica.
+ *
+ * Used to take back a command, from its score after to its score before.
+ * Called from thread0.
+ *
+ * @param id Local replica ID.
+ * @param from Score before the change.
+ * @param to Score after the change.
+ */
+void crdt_apply_change(uint8_t id, const struct sb_score *from, const struct sb_score *to);
+
+/**
+ * @brief Merge one replica state into another, field by field maximum.
+ *
+ * @param into Replica state to grow.
+ * @param from Replica state with the same ID.
+ *
+ * @return true if @p into grew.
+ */
+bool crdt_replica_max(struct sb_crdt_replica *into, const struct sb_crdt_replica *from);
+
+/**
+ * @brief Merge the state of a replica heard from a peer.
+ *
+ * Called from thread0, like the local commands, so that a command never
+ * sees a merge halfway. The replicas of this broadcaster are only merged
+ * before crdt_join_end(), to take back their counts after a restart.
+ *
+ * @param remote Replica state, little endian as on air.
+ *
+ * @return 1 if the state grew, 0 if not, -EPERM for a replica of this
+ *         broadcaster that the peer holds ahead of it after crdt_join_end(),
+ *         -ENOMEM for a new replica with CONFIG_SCOREBOARD_CRDT_REPLICAS full.
+ */
+int crdt_merge(const struct sb_crdt_replica *remote);
+
+/**
+ * @brief Merge the epoch heard from a peer, by its maximum.
+ *
+ * @param remote Epoch of the peer's replica set.
+ *
+ * @return true if the epoch grew.
+ */
+bool crdt_merge_epoch(uint8_t remote);
+
+/**
+ * @brief Stop adopting peers' copies of the local replicas.
+ *
+ * Called from thread0 before the first local command.
+ */
+void crdt_join_end(void);
+
+/**
+ * @brief Merged score of all replicas.
+ *
+ * @param score Score to fill in, the company ID is left as it is.
+ */
+void crdt_score(struct sb_score *score);
+
+/**
+ * @brief Epoch of the shared score.
+ */
+uint8_t crdt_epoch(void);
+
+/**
+ * @brief Sequence of the merged score.
+ *
+ * Count of all steps up and down and serving changes over the replicas,
+ * modulo 2^16. Grows with every change of the score and is the same on
+ * every broadcaster that merged the same replicas.
+ */
+uint16_t crdt_seq(void);
+
+/**
+ * @brief Encode every replica known as manufacturer data.
+ *
+ * The output is the company ID, SB_CRDT_RECORD_ID, the epoch and the
+ * replicas.
+ *
+ * @param buf Output buffer.
+ * @param size Size of @p buf.
+ *
+ * @return Number of bytes written.
+ */
+size_t crdt_encode(uint8_t *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRDT_H_ */
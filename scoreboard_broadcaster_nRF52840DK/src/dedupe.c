@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include "dedupe.h"
+#include "stats.h"
+
+BUILD_ASSERT(DEDUPE_CMDS <= 32, "One valid bit per command word");
+
+bool dedupe_drop(struct dedupe *d, uint8_t cmd, uint8_t seq, uint32_t now_ms)
+{
+	uint32_t age_ms;
+
+	if (cmd >= DEDUPE_CMDS) {
+		return false;
+	}
+
+	if (d->valid & BIT(cmd)) {
+		age_ms = now_ms - d->time_ms[cmd];
+
+		if ((d->seq[cmd] == seq) && (age_ms < CONFIG_SCOREBOARD_DEDUPE_MS)) {
+			STATS_INC(cmd_dup_frames);
+			return true;
+		}
+
+		if ((d->repeat_valid & BIT(cmd)) && (d->repeat_seq[cmd] == seq) &&
+		    ((now_ms - d->repeat_ms[cmd]) < CONFIG_SCOREBOARD_DEDUPE_MS)) {
+			STATS_INC(cmd_dup_frames);
+			return true;
+		}
+
+		/* The window stays anchored at the accepted frame, the repeat's
+		 * own msgSeq is kept for the module reporting it twice
+		 */
+		if ((d->seq[cmd] != seq) && (age_ms < CONFIG_SCOREBOARD_DEDUPE_REPEAT_MS)) {
+			d->repeat_valid |= BIT(cmd);
+			d->repeat_ms[cmd] = now_ms;
+			d->repeat_seq[cmd] = seq;
+			STATS_INC(cmd_dup_repeats);
+			return true;
+		}
+	}
+
+	d->valid |= BIT(cmd);
+	d->repeat_valid &= ~BIT(cmd);
+	d->time_ms[cmd] = now_ms;
+	d->seq[cmd] = seq;
+
+	return false;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef DEDUPE_H_
+#define DEDUPE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "df2301q.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Command word IDs tracked, the scoreboard commands up to undo */
+#define DEDUPE_CMDS (SCORE_UNDO_LAST + 1)
+
+/* Last accepted frame of each command word of one voice input, and the
+ * last repeat of it dropped since
+ */
+struct dedupe {
+	uint32_t valid;                /* Bit per command word */
+	uint32_t time_ms[DEDUPE_CMDS];
+	uint8_t seq[DEDUPE_CMDS];      /* msgSeq of the frame */
+	uint32_t repeat_valid;         /* Bit per command word */
+	uint32_t repeat_ms[DEDUPE_CMDS];
+	uint8_t repeat_seq[DEDUPE_CMDS];
+};
+
+/**
+ * @brief Check a command frame against the last accepted one of the same
+ * command word. Called from thread0.
+ *
+ * A frame with the same msgSeq within CONFIG_SCOREBOARD_DEDUPE_MS is the
+ * module reporting one utterance twice, one with a new msgSeq within
+ * CONFIG_SCOREBOARD_DEDUPE_REPEAT_MS is the operator repeating the command.
+ * Both are counted and dropped. The repeat window starts at the accepted
+ * frame, so repeats do not hold it open. A dropped repeat reported twice
+ * within CONFIG_SCOREBOARD_DEDUPE_MS is a duplicate frame as well.
+ *
+ * @param d State of the voice input.
+ * @param cmd Command word ID.
+ * @param seq msgSeq of the frame.
+ * @param now_ms Uptime in ms.
+ *
+ * @return true if the frame is a duplicate to drop.
+ */
+bool dedupe_drop(struct dedupe *d, uint8_t cmd, uint8_t seq, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEDUPE_H_ */
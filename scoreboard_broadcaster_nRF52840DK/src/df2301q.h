@@ -100,6 +100,17 @@
 #define TEAM_HOME_SERVING                           0x0D 
 #define TEAM_GUEST_SERVING                          0x0E 
 #define SCORE_BOARD_RESET                           0x0F
+#define TEAM_HOME_PLUS_ONE_TIMEOUT                  0x10
+#define TEAM_GUEST_PLUS_ONE_TIMEOUT                 0x11
+#define TEAM_HOME_PLUS_ONE_FOUL                     0x12
+#define TEAM_GUEST_PLUS_ONE_FOUL                    0x13
+#define NEXT_PERIOD                                 0x14
+#define CLOCK_START                                 0x15
+#define CLOCK_STOP                                  0x16
+#define CLOCK_RESET                                 0x17
+#define CLOCK_PLUS_ONE_SECOND                       0x18
+#define CLOCK_MINUS_ONE_SECOND                      0x19
+#define SCORE_UNDO_LAST                             0x1A
 
 #define TEAM_HOME_SERVING_BIT                       0  //1
 #define TEAM_GUEST_SERVING_BIT                      1  //2
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* GATT scoreboard service.
+ *
+ * Observers that can connect get every score change as a notification
+ * within one connection interval instead of at the next advertising event,
+ * and the link layer acknowledges it. Advertising carries on unchanged, it
+ * is where observers fall back to when their connection drops.
+ *
+ * The service is advertised on a third, connectable set. A connectable set
+ * stops when it is connected to, it is restarted as long as fewer than
+ * CONFIG_BT_MAX_CONN observers are connected. That bounds the fanout of a
+ * score change to CONFIG_BT_MAX_CONN notifications.
+ *
+ * Scores come from a listener of adv_payload_chan, so a notification is
+ * sent in thread0 as soon as the payload is published.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/zbus/zbus.h>
+#include <string.h>
+#include <scoreboard_proto.h>
+#include <sb_trace.h>
+#include "channels.h"
+#include "gatt.h"
+#include "stats.h"
+
+LOG_MODULE_DECLARE(Scoreboard, LOG_LEVEL_INF);
+
+/* Connection interval 7.5 ms to 15 ms, in 1.25 ms units */
+#define CONN_INTERVAL_MIN 6
+#define CONN_INTERVAL_MAX 12
+#define CONN_TIMEOUT      400 /* 4 s, in 10 ms units */
+
+static const struct bt_uuid_128 service_uuid = BT_UUID_INIT_128(SB_GATT_SERVICE_UUID_VAL);
+static const struct bt_uuid_128 score_uuid = BT_UUID_INIT_128(SB_GATT_SCORE_UUID_VAL);
+
+/* Score as last notified, struct sb_score */
+static uint8_t score[sizeof(struct sb_score)];
+
+static const struct bt_le_adv_param gatt_adv_param = {
+	.id = BT_ID_DEFAULT,
+	.sid = SB_ADV_SID_GATT,
+	.options = BT_LE_ADV_OPT_EXT_ADV | BT_LE_ADV_OPT_CONNECTABLE,
+	.interval_min = 160, /* 100ms (160*0.625ms) */
+	.interval_max = 161, /* 100.625ms (161*0.625ms) */
+};
+
+static const struct bt_data gatt_ad[] = {
+	BT_DATA_BYTES(BT_DATA_FLAGS, (BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR)),
+	BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+	BT_DATA_BYTES(BT_DATA_UUID128_ALL, SB_GATT_SERVICE_UUID_VAL),
+};
+
+static struct bt_le_ext_adv *gatt_adv;
+static atomic_t connections;
+
+static ssize_t read_score(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			  void *buf, uint16_t len, uint16_t offset)
+{
+	return bt_gatt_attr_read(conn, attr, buf, len, offset, score, sizeof(score));
+}
+
+BT_GATT_SERVICE_DEFINE(sb_svc,
+	BT_GATT_PRIMARY_SERVICE(&service_uuid),
+	BT_GATT_CHARACTERISTIC(&score_uuid.uuid, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+			       BT_GATT_PERM_READ, read_score, NULL, NULL),
+	BT_GATT_CCC(NULL, BT_GATT_PERM_READ | BT_GATT_PERM_WRITE),
+);
+
+static void adv_restart_handler(struct k_work *work)
+{
+	int err;
+
+	if (atomic_get(&connections) >= CONFIG_BT_MAX_CONN) {
+		return;
+	}
+
+	err = bt_le_ext_adv_start(gatt_adv, BT_LE_EXT_ADV_START_DEFAULT);
+	if (err && (err != -EALREADY)) {
+		LOG_ERR("Failed to restart GATT advertising (err %d)", err);
+	}
+}
+
+static K_WORK_DEFINE(adv_restart_work, adv_restart_handler);
+
+static void connected(struct bt_conn *conn, uint8_t err)
+{
+	static const struct bt_le_conn_param param =
+		BT_LE_CONN_PARAM_INIT(CONN_INTERVAL_MIN, CONN_INTERVAL_MAX, 0, CONN_TIMEOUT);
+
+	if (err) {
+		return;
+	}
+
+	atomic_inc(&connections);
+
+	/* The observer asks for the same, this covers other centrals */
+	(void)bt_conn_le_param_update(conn, &param);
+
+	k_work_submit(&adv_restart_work);
+}
+
+static void disconnected(struct bt_conn *conn, uint8_t reason)
+{
+	atomic_dec(&connections);
+}
+
+/* A connection object is free again, advertising can use it */
+static void recycled(void)
+{
+	k_work_submit(&adv_restart_work);
+}
+
+BT_CONN_CB_DEFINE(gatt_conn_callbacks) = {
+	.connected = connected,
+	.disconnected = disconnected,
+	.recycled = recycled,
+};
+
+/* Notify a new score to every subscribed observer. The cost is one
+ * notification per connection, at most CONFIG_BT_MAX_CONN.
+ */
+static void gatt_notify_score(const void *data, size_t len)
+{
+	uint32_t start_cyc;
+	int err;
+
+	memcpy(score, data, MIN(len, sizeof(score)));
+
+	if (atomic_get(&connections) == 0) {
+		return;
+	}
+
+	start_cyc = k_cycle_get_32();
+	SB_TRACE_BEGIN(SB_TRACE_GATT_NOTIFY, atomic_get(&connections));
+
+	/* NULL notifies every connection that enabled notifications */
+	err = bt_gatt_notify(NULL, &sb_svc.attrs[1], score, sizeof(score));
+
+	SB_TRACE_END(SB_TRACE_GATT_NOTIFY, atomic_get(&connections));
+	STATS_HIST(gatt_notify_us, k_cyc_to_us_floor32(k_cycle_get_32() - start_cyc));
+
+	/* -ENOTCONN: connected, but nobody subscribed yet */
+	if (err == -ENOTCONN) {
+		return;
+	}
+
+	if (err) {
+		STATS_INC(gatt_notify_errors);
+		return;
+	}
+
+	STATS_INC(gatt_notifies);
+}
+
+static void adv_payload_cb(const struct zbus_channel *chan)
+{
+	gatt_notify_score(zbus_chan_const_msg(chan), sizeof(struct sb_score));
+}
+
+ZBUS_LISTENER_DEFINE(gatt_score_lis, adv_payload_cb);
+
+int gatt_init(const void *data, size_t len)
+{
+	int err;
+
+	memcpy(score, data, MIN(len, sizeof(score)));
+
+	err = zbus_chan_add_obs(&adv_payload_chan, &gatt_score_lis, K_FOREVER);
+	if (err) {
+		return err;
+	}
+
+	err = bt_le_ext_adv_create(&gatt_adv_param, NULL, &gatt_adv);
+	if (err) {
+		return err;
+	}
+
+	err = bt_le_ext_adv_set_data(gatt_adv, gatt_ad, ARRAY_SIZE(gatt_ad), NULL, 0);
+	if (err) {
+		return err;
+	}
+
+	return bt_le_ext_adv_start(gatt_adv, BT_LE_EXT_ADV_START_DEFAULT);
+}
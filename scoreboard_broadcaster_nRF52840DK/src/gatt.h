@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef GATT_H_
+#define GATT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the connectable advertising set of the GATT scoreboard
+ * service and notify every score published on adv_payload_chan.
+ *
+ * @param score Initial score, struct sb_score.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int gatt_init(const void *score, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GATT_H_ */
@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Score event journal.
+ *
+ * thread0 journals every command word it applies in a RAM ring of
+ * CONFIG_SCOREBOARD_JOURNAL_LEN entries, with the score before and after
+ * it and the voice input it came from. Each command that changed something
+ * links to the command undo takes back after it, so "undo last" finds the
+ * newest command not undone yet in O(1), and undoing again walks further
+ * back. Undos and the scores merged from peer broadcasters are journaled
+ * as well.
+ *
+ * With CONFIG_SCOREBOARD_JOURNAL_FLASH the entries are appended to a flash
+ * circular buffer (FCB) on the storage partition, from the system
+ * workqueue every CONFIG_SCOREBOARD_JOURNAL_FLUSH_EVERY entries and at the
+ * end of a period. The oldest sector is erased when the log is full.
+ *
+ * journal_replay() applies the commands of the RAM ring or the flash log
+ * again with score_apply_cmd(), checks that they lead to the journaled
+ * scores and gathers the statistics of the match.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#if defined(CONFIG_SCOREBOARD_JOURNAL_FLASH)
+#include <zephyr/fs/fcb.h>
+#include <zephyr/storage/flash_map.h>
+#endif
+#include <scoreboard_proto.h>
+#include "df2301q.h"
+#include "journal.h"
+#include "score.h"
+#include "stats.h"
+
+LOG_MODULE_DECLARE(Scoreboard, LOG_LEVEL_INF);
+
+#define JOURNAL_LEN CONFIG_SCOREBOARD_JOURNAL_LEN
+
+/* The ring slot of an entry is its seq modulo the length, also across the
+ * 16 bit wrap
+ */
+BUILD_ASSERT(IS_POWER_OF_TWO(JOURNAL_LEN), "journal length must be a power of two");
+
+#define PRINT_ENTRIES 16
+
+static struct journal_entry ring[JOURNAL_LEN];
+static uint16_t head_seq;   /* seq of the next entry */
+static uint16_t count;      /* Entries in the ring */
+static uint16_t undo_seq;   /* Entry undo takes back next */
+static bool undo_valid;
+static uint16_t flushed_seq; /* seq of the next entry to write to flash */
+
+static K_MUTEX_DEFINE(journal_lock);
+
+/* Statistics gathered by a replay */
+struct replay {
+	struct sb_score score;
+	bool started;
+	uint16_t next_seq;
+	uint32_t entries;
+	uint32_t undos;
+	uint32_t merges;
+	uint32_t restarts;
+	uint32_t mismatches;
+	uint32_t first_ms;
+	uint32_t last_ms;
+	uint32_t points[2];
+	uint32_t taken_back[2];
+	uint32_t max_lead[2];
+	uint32_t lead_changes;
+	int leader;
+};
+
+static bool in_ring(uint16_t seq)
+{
+	return (uint16_t)(head_seq - seq - 1) < count;
+}
+
+static struct journal_entry *slot(uint16_t seq)
+{
+	return &ring[seq & (JOURNAL_LEN - 1)];
+}
+
+void journal_append(uint8_t cmd, uint8_t source, const struct sb_score *before,
+		    const struct sb_score *after, bool match_changed)
+{
+	struct journal_entry *e;
+	uint16_t unflushed;
+
+	k_mutex_lock(&journal_lock, K_FOREVER);
+
+	e = slot(head_seq);
+	e->time_ms = k_uptime_get_32();
+	e->seq = head_seq;
+	e->undo_seq = 0;
+	e->cmd = cmd;
+	e->flags = (memcmp(before, after, sizeof(*before)) != 0) ? JOURNAL_SCORE : 0;
+	e->flags |= match_changed ? JOURNAL_MATCH : 0;
+	e->before = *before;
+	e->after = *after;
+
+	head_seq++;
+	count = MIN(count + 1, JOURNAL_LEN);
+
+	/* Commands that changed nothing are kept for the record only */
+	if (((e->flags & (JOURNAL_SCORE | JOURNAL_MATCH)) != 0) &&
+	    (cmd != SCORE_UNDO_LAST) && (cmd != JOURNAL_CMD_MERGE)) {
+		if (undo_valid) {
+			e->undo_seq = undo_seq;
+			e->flags |= JOURNAL_PREV;
+		}
+		undo_seq = e->seq;
+		undo_valid = true;
+	}
+	e->flags |= (source & 0x0f) << 4;
+
+	unflushed = head_seq - flushed_seq;
+	k_mutex_unlock(&journal_lock);
+
+	STATS_INC(journal_entries);
+
+	if (unflushed >= CONFIG_SCOREBOARD_JOURNAL_FLUSH_EVERY) {
+		journal_flush();
+	}
+}
+
+int journal_undo_peek(struct journal_entry *next)
+{
+	int err = 0;
+
+	k_mutex_lock(&journal_lock, K_FOREVER);
+	if (undo_valid && in_ring(undo_seq)) {
+		*next = *slot(undo_seq);
+	} else {
+		err = -ENOENT;
+	}
+	k_mutex_unlock(&journal_lock);
+
+	return err;
+}
+
+int journal_undo(struct journal_entry *undone)
+{
+	k_mutex_lock(&journal_lock, K_FOREVER);
+
+	if (!undo_valid || !in_ring(undo_seq)) {
+		undo_valid = false;
+		k_mutex_unlock(&journal_lock);
+		return -ENOENT;
+	}
+
+	*undone = *slot(undo_seq);
+	undo_seq = undone->undo_seq;
+	undo_valid = (undone->flags & JOURNAL_PREV) != 0;
+	k_mutex_unlock(&journal_lock);
+
+	STATS_INC(journal_undos);
+
+	return 0;
+}
+
+#if defined(CONFIG_SCOREBOARD_JOURNAL_FLASH)
+
+#define JOURNAL_PARTITION_ID  FIXED_PARTITION_ID(storage_partition)
+#define JOURNAL_FCB_MAGIC     0x53424a4c /* "SBJL" */
+#define JOURNAL_FCB_VERSION   1
+#define JOURNAL_FCB_SECTORS   8
+
+static struct flash_sector fcb_sectors[JOURNAL_FCB_SECTORS];
+static struct fcb fcb;
+static bool fcb_ready;
+
+int journal_init(void)
+{
+	uint32_t sector_cnt = ARRAY_SIZE(fcb_sectors);
+	int err;
+
+	err = flash_area_get_sectors(JOURNAL_PARTITION_ID, &sector_cnt, fcb_sectors);
+	if (err) {
+		return err;
+	}
+
+	fcb.f_magic = JOURNAL_FCB_MAGIC;
+	fcb.f_version = JOURNAL_FCB_VERSION;
+	fcb.f_sectors = fcb_sectors;
+	fcb.f_sector_cnt = sector_cnt;
+	fcb.f_scratch_cnt = 0;
+
+	err = fcb_init(JOURNAL_PARTITION_ID, &fcb);
+	if (err) {
+		return err;
+	}
+
+	fcb_ready = true;
+
+	return 0;
+}
+
+static int flash_append(const struct journal_entry *e)
+{
+	struct fcb_entry loc;
+	int err;
+
+	err = fcb_append(&fcb, sizeof(*e), &loc);
+	if (err == -ENOSPC) {
+		/* Full, drop the oldest sector */
+		err = fcb_rotate(&fcb);
+		if (!err) {
+			err = fcb_append(&fcb, sizeof(*e), &loc);
+		}
+	}
+	if (err) {
+		return err;
+	}
+
+	err = flash_area_write(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), e, sizeof(*e));
+	if (err) {
+		return err;
+	}
+
+	return fcb_append_finish(&fcb, &loc);
+}
+
+static void flush_work_handler(struct k_work *work)
+{
+	struct journal_entry e;
+	uint32_t start_cyc;
+	int err;
+
+	if (!fcb_ready) {
+		return;
+	}
+
+	while (true) {
+		k_mutex_lock(&journal_lock, K_FOREVER);
+
+		if (flushed_seq == head_seq) {
+			k_mutex_unlock(&journal_lock);
+			break;
+		}
+
+		if (!in_ring(flushed_seq)) {
+			/* Overwritten before it could be written */
+			sb_stat_add(&stats.journal_overruns,
+				    (uint16_t)(head_seq - count - flushed_seq));
+			flushed_seq = head_seq - count;
+			k_mutex_unlock(&journal_lock);
+			continue;
+		}
+
+		e = *slot(flushed_seq);
+		flushed_seq++;
+		k_mutex_unlock(&journal_lock);
+
+		start_cyc = k_cycle_get_32();
+		err = flash_append(&e);
+		STATS_HIST(journal_flush_us, k_cyc_to_us_floor32(k_cycle_get_32() - start_cyc));
+
+		if (err) {
+			STATS_INC(journal_flash_errors);
+			LOG_ERR("Journal flash write failed (err %d)", err);
+			break;
+		}
+
+		STATS_INC(journal_flushed);
+	}
+}
+
+static K_WORK_DEFINE(flush_work, flush_work_handler);
+
+void journal_flush(void)
+{
+	k_work_submit(&flush_work);
+}
+
+static int clear_flash(void)
+{
+	return fcb_ready ? fcb_clear(&fcb) : 0;
+}
+
+#else
+
+int journal_init(void)
+{
+	return 0;
+}
+
+void journal_flush(void)
+{
+}
+
+static int clear_flash(void)
+{
+	return 0;
+}
+
+#endif /* CONFIG_SCOREBOARD_JOURNAL_FLASH */
+
+int journal_clear(void)
+{
+	k_mutex_lock(&journal_lock, K_FOREVER);
+	count = 0;
+	undo_valid = false;
+	flushed_seq = head_seq;
+	k_mutex_unlock(&journal_lock);
+
+	return clear_flash();
+}
+
+void journal_print(const struct shell *sh)
+{
+	struct journal_entry e;
+	uint16_t n;
+
+	k_mutex_lock(&journal_lock, K_FOREVER);
+	n = MIN(count, PRINT_ENTRIES);
+	shell_print(sh, "%u entries, next seq %u", count, head_seq);
+	if (IS_ENABLED(CONFIG_SCOREBOARD_JOURNAL_FLASH)) {
+		shell_print(sh, "%u not in flash yet", (uint16_t)(head_seq - flushed_seq));
+	}
+	k_mutex_unlock(&journal_lock);
+
+	shell_print(sh, "%-6s %10s %-5s %3s %11s %5s %5s", "seq", "ms", "cmd", "src", "points",
+		    "sets", "flags");
+
+	for (uint16_t i = n; i > 0; i--) {
+		k_mutex_lock(&journal_lock, K_FOREVER);
+		e = *slot(head_seq - i);
+		k_mutex_unlock(&journal_lock);
+
+		shell_print(sh, "%-6u %10u 0x%02x  %3u %5u-%-5u %2u-%-2u %c%c%c", e.seq, e.time_ms,
+			    e.cmd, JOURNAL_SOURCE(e.flags), sys_le16_to_cpu(e.after.home_points),
+			    sys_le16_to_cpu(e.after.guest_points), e.after.home_sets,
+			    e.after.guest_sets, (e.flags & JOURNAL_SCORE) ? 's' : '-',
+			    (e.flags & JOURNAL_MATCH) ? 'm' : '-',
+			    (e.cmd == SCORE_UNDO_LAST) ? 'u' : '-');
+	}
+}
+
+static void replay_points(struct replay *r, int team, uint16_t before_le, uint16_t after_le)
+{
+	int delta = (int)sys_le16_to_cpu(after_le) - (int)sys_le16_to_cpu(before_le);
+
+	if (delta > 0) {
+		r->points[team] += delta;
+	} else {
+		r->taken_back[team] -= delta;
+	}
+}
+
+static void replay_step(struct replay *r, const struct journal_entry *e)
+{
+	struct sb_score before;
+	int lead, leader;
+
+	/* A new boot numbers its entries from 0 again */
+	if (!r->started || (e->seq != r->next_seq)) {
+		r->restarts += r->started ? 1 : 0;
+		r->score = e->before;
+		if (!r->started) {
+			r->first_ms = e->time_ms;
+		}
+		r->started = true;
+	} else if (memcmp(&r->score, &e->before, sizeof(r->score)) != 0) {
+		r->mismatches++;
+		r->score = e->before;
+	}
+
+	before = r->score;
+
+	if (e->cmd == SCORE_UNDO_LAST) {
+		r->undos++;
+		r->score = e->after;
+	} else if (e->cmd == JOURNAL_CMD_MERGE) {
+		r->merges++;
+		r->score = e->after;
+	} else {
+		(void)score_apply_cmd(&r->score, e->cmd);
+		if (memcmp(&r->score, &e->after, sizeof(r->score)) != 0) {
+			r->mismatches++;
+			r->score = e->after;
+		}
+	}
+
+	/* A reset is not points taken back */
+	if (e->cmd != SCORE_BOARD_RESET) {
+		replay_points(r, 0, before.home_points, r->score.home_points);
+		replay_points(r, 1, before.guest_points, r->score.guest_points);
+	}
+
+	lead = (int)sys_le16_to_cpu(r->score.home_points) -
+	       (int)sys_le16_to_cpu(r->score.guest_points);
+	leader = (lead > 0) ? 1 : ((lead < 0) ? -1 : 0);
+	if (leader != 0) {
+		if ((r->leader != 0) && (leader != r->leader)) {
+			r->lead_changes++;
+		}
+		r->leader = leader;
+	}
+	r->max_lead[0] = MAX(r->max_lead[0], (uint32_t)MAX(lead, 0));
+	r->max_lead[1] = MAX(r->max_lead[1], (uint32_t)MAX(-lead, 0));
+
+	r->next_seq = e->seq + 1;
+	r->last_ms = e->time_ms;
+	r->entries++;
+}
+
+#if defined(CONFIG_SCOREBOARD_JOURNAL_FLASH)
+static int replay_flash_cb(struct fcb_entry_ctx *loc_ctx, void *arg)
+{
+	struct journal_entry e;
+	int err;
+
+	if (loc_ctx->loc.fe_data_len != sizeof(e)) {
+		return 0;
+	}
+
+	err = flash_area_read(loc_ctx->fap, FCB_ENTRY_FA_DATA_OFF(loc_ctx->loc), &e, sizeof(e));
+	if (err) {
+		return err;
+	}
+
+	replay_step(arg, &e);
+
+	return 0;
+}
+#endif
+
+int journal_replay(const struct shell *sh, bool flash)
+{
+	struct replay r = {0};
+	uint32_t start_cyc, replay_us;
+	int err = 0;
+
+	start_cyc = k_cycle_get_32();
+
+	if (flash) {
+#if defined(CONFIG_SCOREBOARD_JOURNAL_FLASH)
+		err = fcb_ready ? fcb_walk(&fcb, NULL, replay_flash_cb, &r) : -ENODEV;
+#else
+		err = -ENOTSUP;
+#endif
+	} else {
+		k_mutex_lock(&journal_lock, K_FOREVER);
+		for (uint16_t i = count; i > 0; i--) {
+			replay_step(&r, slot(head_seq - i));
+		}
+		k_mutex_unlock(&journal_lock);
+	}
+
+	replay_us = k_cyc_to_us_floor32(k_cycle_get_32() - start_cyc);
+
+	if (err) {
+		shell_error(sh, "replay failed (err %d)", err);
+		return err;
+	}
+
+	shell_print(sh, "%u entries replayed in %u us, %u mismatches, %u restarts", r.entries,
+		    replay_us, r.mismatches, r.restarts);
+	shell_print(sh, "%u ms of play, %u commands, %u undone, %u merged from peers",
+		    r.last_ms - r.first_ms, r.entries - r.undos - r.merges, r.undos, r.merges);
+	shell_print(sh, "home:  %u points, %u taken back, largest lead %u", r.points[0],
+		    r.taken_back[0], r.max_lead[0]);
+	shell_print(sh, "guest: %u points, %u taken back, largest lead %u", r.points[1],
+		    r.taken_back[1], r.max_lead[1]);
+	shell_print(sh, "%u lead changes", r.lead_changes);
+
+	return (r.mismatches == 0) ? 0 : -EIO;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/util.h>
+#include <scoreboard_proto.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Journal entry flags, the upper four bits are the source */
+#define JOURNAL_SCORE BIT(0) /* The score changed */
+#define JOURNAL_MATCH BIT(1) /* The match record changed */
+#define JOURNAL_PREV  BIT(2) /* undo_seq is valid */
+#define JOURNAL_SOURCE(_flags) ((_flags) >> 4)
+
+/* Command of an entry for replicas merged from a peer */
+#define JOURNAL_CMD_MERGE 0xFF
+
+/* One applied command word, in RAM and in the flash log */
+struct journal_entry {
+	uint32_t time_ms;      /* Uptime when applied */
+	uint16_t seq;          /* Counts entries from boot */
+	uint16_t undo_seq;     /* Entry to undo after this one */
+	uint8_t cmd;           /* Command word ID, SCORE_UNDO_LAST for an undo,
+				* JOURNAL_CMD_MERGE for a merge
+				*/
+	uint8_t flags;
+	struct sb_score before;
+	struct sb_score after;
+} __packed;
+
+/**
+ * @brief Open the flash log, with CONFIG_SCOREBOARD_JOURNAL_FLASH.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int journal_init(void);
+
+/**
+ * @brief Journal an applied command word, an undo or a merge. Called from
+ * thread0.
+ *
+ * Commands that changed something can be undone, undos and merges cannot.
+ *
+ * @param cmd Command word ID, SCORE_UNDO_LAST or JOURNAL_CMD_MERGE.
+ * @param source Replica ID of the voice input, 0 to 15.
+ * @param before Score before the command.
+ * @param after Score after the command.
+ * @param match_changed The command changed the match record.
+ */
+void journal_append(uint8_t cmd, uint8_t source, const struct sb_score *before,
+		    const struct sb_score *after, bool match_changed);
+
+/**
+ * @brief Find the newest command word not undone yet, in O(1).
+ *
+ * The entry is taken off the undo chain, so the next call returns the
+ * command before it. Taking back the score and the match record and
+ * journaling the undo are left to the caller. Called from thread0.
+ *
+ * @param undone Entry of the command to take back.
+ *
+ * @return 0 on success, -ENOENT if there is nothing to undo.
+ */
+int journal_undo(struct journal_entry *undone);
+
+/**
+ * @brief Find the command journal_undo() returns next, without taking it
+ * off the undo chain. Called from thread0.
+ *
+ * @param next Entry of the command to take back.
+ *
+ * @return 0 on success, -ENOENT if there is nothing to undo.
+ */
+int journal_undo_peek(struct journal_entry *next);
+
+/** @brief Write the entries not in the flash log yet, from the system workqueue. */
+void journal_flush(void);
+
+/** @brief Drop the RAM journal and erase the flash log. */
+int journal_clear(void);
+
+/**
+ * @brief Print the newest journal entries.
+ *
+ * @param sh Shell to print to.
+ */
+void journal_print(const struct shell *sh);
+
+/**
+ * @brief Replay the journal and print the match statistics.
+ *
+ * Every command is applied again to check that it leads to the journaled
+ * score.
+ *
+ * @param sh Shell to print to.
+ * @param flash Replay the flash log instead of the RAM journal.
+ *
+ * @return 0 if every command led to the journaled score, -EIO otherwise,
+ *         another negative errno if the flash log cannot be read.
+ */
+int journal_replay(const struct shell *sh, bool flash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JOURNAL_H_ */
@@ -13,9 +13,27 @@
 #include <dk_buttons_and_leds.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/sys/printk.h>
+#include <zephyr/sys/byteorder.h>
 #include <string.h>
 #include <zephyr/drivers/uart.h>
+#include <zephyr/random/rand32.h>
+#include <zephyr/zbus/zbus.h>
+#include <scoreboard_proto.h>
+#include <sb_chan.h>
+#include <sb_history.h>
+#include <sb_trace.h>
+#include "channels.h"
+#include "crdt.h"
+#include "dedupe.h"
 #include "df2301q.h"
+#include "gatt.h"
+#include "journal.h"
+#include "match.h"
+#include "pawr.h"
+#include "peer.h"
+#include "phy.h"
+#include "score.h"
+#include "stats.h"
 
 #define COMPANY_ID_CODE 0x0059 // Nordic BLE ID
 
@@ -35,32 +53,99 @@
 #define RECEIVE_TIMEOUT 1200
 
 /* RTOS Task properties */
-#define SB_STACKSIZE       1024
+#define SB_STACKSIZE       2048 /* The zbus listeners run on it */
 #define SB_PRIORITY        5 
 
-/* Define semaphore */
-K_SEM_DEFINE(sem, 0, 1);
+/* Source of the frames thread0 gets for merges from peer broadcasters */
+#define VOICE_SOURCE_PEER 0xFF
 
-/* Declare the structure for your custom data  */
+/* A frame of one voice input, source is the index in voice_uarts */
+struct voice_frame {
+	uint8_t source;
+	uint8_t data[RECEIVE_BUFF_SIZE];
+};
+
+/* Frames from the UART ISRs and merges from the BT RX thread, for thread0.
+ * zbus cannot be published to from an ISR, thread0 publishes the commands.
+ */
+K_MSGQ_DEFINE(voice_msgq, sizeof(struct voice_frame), 8, 1);
+
+/* Declare the structure for your custom data, laid out as struct
+ * sb_score_adv. Points and seq are kept little endian, see score_apply_cmd().
+ */
 typedef struct adv_mfg_data {
 	uint16_t company_code; /* Company Identifier Code. */
-	uint8_t team_home_points;
-	uint8_t team_guest_points;
+	uint16_t team_home_points;
+	uint16_t team_guest_points;
 	uint8_t team_home_set;
 	uint8_t team_guest_set;
 	uint8_t serving; 
-} adv_mfg_data_type;
-
-/* Create an LE Advertising Parameters variable */
-static struct bt_le_adv_param *adv_param = BT_LE_ADV_PARAM(BT_LE_ADV_OPT_NONE, /* No options specified */
+	uint16_t seq; /* Score changes, so that relays never go back */
+	uint8_t epoch; /* Random per boot, a new one restarts seq */
+	uint8_t hops; /* Always 0 here, relays count up */
+	uint8_t history[SB_SCORE_HISTORY_LEN]; /* Last score changes, newest first */
+} __packed adv_mfg_data_type;
+
+BUILD_ASSERT(sizeof(adv_mfg_data_type) == sizeof(struct sb_score_adv));
+
+/* Create an LE Advertising Parameters variable.
+ * The score is sent with extended advertising so the controller puts an
+ * Advertising Data ID (ADI) in every AUX_ADV_IND. The controller picks a new
+ * DID only when the host writes new advertising data, so observers that
+ * filter duplicates drop the unchanged repeats but still get every score
+ * change.
+ */
+static struct bt_le_adv_param *adv_param = BT_LE_ADV_PARAM(BT_LE_ADV_OPT_EXT_ADV | PHY_ADV_OPTIONS, /* Extended advertising, non-connectable, non-scannable, on CONFIG_SCOREBOARD_PHY */
 											800, /* Min Advertising Interval 500ms (800*0.625ms) */
 											801, /* Max Advertising Interval 500.625ms (801*0.625ms) */
 											NULL); /* Set to NULL for undirected advertising */
 
-/* Define and initialize a variable of type adv_mfg_data_type */
+/* Define and initialize a variable of type adv_mfg_data_type, the payload
+ * last handed to the controller
+ */
 static adv_mfg_data_type adv_mfg_data = {COMPANY_ID_CODE, 0x00, 0x00, 0x00, 0x00, 0x00};
 
-static unsigned char url_data[] = { };
+/* Extended advertising set carrying the score */
+static struct bt_le_ext_adv *adv;
+
+/* Legacy advertising set with the score in the layout of observers without
+ * extended scanning
+ */
+static const struct bt_le_adv_param legacy_adv_param = {
+	.id = BT_ID_DEFAULT,
+	.options = BT_LE_ADV_OPT_NONE,
+	.interval_min = 800, /* 500ms (800*0.625ms) */
+	.interval_max = 801, /* 500.625ms (801*0.625ms) */
+};
+
+static struct bt_le_ext_adv *legacy_adv;
+static struct sb_score_legacy legacy_data = { .company_id = COMPANY_ID_CODE };
+
+/* Advertising data updates at the start of the current match period */
+static uint32_t period_adv_update_base;
+
+/* Second extended advertising set carrying the TLV match record. The clock
+ * anchor in it is only sent on start/stop/adjust, so a short interval keeps
+ * the delay until observers first catch a new anchor small.
+ */
+static const struct bt_le_adv_param match_adv_param = {
+	.id = BT_ID_DEFAULT,
+	.sid = SB_ADV_SID_MATCH,
+	.options = BT_LE_ADV_OPT_EXT_ADV | PHY_ADV_OPTIONS,
+	.interval_min = 320, /* 200ms (320*0.625ms) */
+	.interval_max = 321, /* 200.625ms (321*0.625ms) */
+};
+
+#define MATCH_DATA_MAX_LEN 144
+
+static struct bt_le_ext_adv *match_adv;
+static uint8_t match_data[MATCH_DATA_MAX_LEN];
+static uint8_t match_data_sent[MATCH_DATA_MAX_LEN];
+static size_t match_data_len;
+static size_t match_data_sent_len;
+
+/* Serializes the match record between thread0 and the clock work */
+static K_MUTEX_DEFINE(match_lock);
 
 LOG_MODULE_REGISTER(Scoreboard, LOG_LEVEL_INF);
 
@@ -71,65 +156,475 @@ static const struct bt_data ad[] = {
 	BT_DATA(BT_DATA_MANUFACTURER_DATA, (unsigned char *)&adv_mfg_data, sizeof(adv_mfg_data)),
 };
 
-static const struct bt_data sd[] = {
-	BT_DATA(BT_DATA_URI, url_data, sizeof(url_data)),
+static const struct bt_data legacy_ad[] = {
+	BT_DATA_BYTES(BT_DATA_FLAGS, BT_LE_AD_NO_BREDR),
+	BT_DATA(BT_DATA_NAME_COMPLETE, DEVICE_NAME, DEVICE_NAME_LEN),
+	BT_DATA(BT_DATA_MANUFACTURER_DATA, (unsigned char *)&legacy_data, sizeof(legacy_data)),
+};
+
+/* Match record advertising data, the manufacturer data length is set when
+ * the record is encoded.
+ */
+static struct bt_data match_ad[] = {
+	BT_DATA_BYTES(BT_DATA_FLAGS, BT_LE_AD_NO_BREDR),
+	BT_DATA(BT_DATA_NAME_COMPLETE, DEVICE_NAME, DEVICE_NAME_LEN),
+	BT_DATA(BT_DATA_MANUFACTURER_DATA, match_data, 0),
+};
+
+/* UARTs of the voice inputs, the voice-uarts of the zephyr,user node or
+ * uart0. Each one is a replica of the score, see crdt.c.
+ */
+#define VOICE_UART_GET(node_id, prop, idx) DEVICE_DT_GET(DT_PHANDLE_BY_IDX(node_id, prop, idx)),
+
+static const struct device *const voice_uarts[] = {
+#if DT_NODE_HAS_PROP(DT_PATH(zephyr_user), voice_uarts)
+	DT_FOREACH_PROP_ELEM(DT_PATH(zephyr_user), voice_uarts, VOICE_UART_GET)
+#else
+	DEVICE_DT_GET(DT_NODELABEL(uart0)),
+#endif
 };
 
-/* Get the device pointer of the UART hardware */
-const struct device *uart= DEVICE_DT_GET(DT_NODELABEL(uart0));
+BUILD_ASSERT(CONFIG_SCOREBOARD_REPLICA_BASE + ARRAY_SIZE(voice_uarts) <= 16,
+	     "Replica IDs of the voice inputs must stay below 16");
+BUILD_ASSERT(ARRAY_SIZE(voice_uarts) <= CONFIG_SCOREBOARD_CRDT_REPLICAS,
+	     "CONFIG_SCOREBOARD_CRDT_REPLICAS must cover every voice input");
+BUILD_ASSERT(CONFIG_BT_EXT_ADV_MAX_ADV_SET >= CONFIG_SCOREBOARD_ADV_SETS,
+	     "CONFIG_BT_EXT_ADV_MAX_ADV_SET must cover CONFIG_SCOREBOARD_ADV_SETS");
+
+/* Define the receive buffers, one per voice input */
+static uint8_t rx_bufs[ARRAY_SIZE(voice_uarts)][RECEIVE_BUFF_SIZE];
 
-/* Define the receive buffer */
-static uint8_t rx_buf[RECEIVE_BUFF_SIZE] = {0};
+/* Last accepted command frames of each voice input, for thread0 */
+static struct dedupe dedupe[ARRAY_SIZE(voice_uarts)];
 
-uint8_t flag = 0;
-static uint8_t DF2301Q_CMD = 0;
 
-/* Define the callback function for UART */
+/* Define the callback function for UART, user_data is the voice input */
 static void uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
 {
+	uint8_t source = (uint8_t)(uintptr_t)user_data;
+	uint8_t *rx_buf = rx_bufs[source];
+	struct voice_frame frame;
+
+	SB_TRACE_BEGIN(SB_TRACE_UART_CB, evt->type);
+
 	switch (evt->type) {
 
 	case UART_RX_RDY:
 
 		uart_rx_disable(dev);
-
-	    if(flag == 0)
-		{
-			dk_set_led(DK_LED3, 1);	
-			flag = 1;
-		}
-		else if(flag == 1)
-		{
-			dk_set_led(DK_LED3, 0);
-			flag = 0;
-		}	
+		STATS_INC(uart_frames_rx);
 
 		if((evt->data.rx.len) == 13)
 		{
-			uart_rx_enable(dev ,rx_buf,sizeof rx_buf,RECEIVE_TIMEOUT);
-			DF2301Q_CMD = 1;
-			k_sem_give(&sem);
-
+			frame.source = source;
+			memcpy(frame.data, &evt->data.rx.buf[evt->data.rx.offset], sizeof(frame.data));
+			if(k_msgq_put(&voice_msgq, &frame, K_NO_WAIT) != 0)
+			{
+				STATS_INC(uart_frames_dropped);
+			}
 		}
 		else if((evt->data.rx.len) == 12)
 		{
 			dk_set_led(DK_LED1, 0);
 			dk_set_led(DK_LED2, 0);
-			DF2301Q_CMD = 0;
+		}
+		else
+		{
+			STATS_INC(uart_frames_rejected);
 		}
 
-		uart_rx_enable(dev ,rx_buf,sizeof rx_buf,RECEIVE_TIMEOUT);
-	
-		k_sem_give(&sem);	
+		uart_rx_enable(dev ,rx_buf,RECEIVE_BUFF_SIZE,RECEIVE_TIMEOUT);
 	break;
 
 	case UART_RX_DISABLED:
-		uart_rx_enable(dev ,rx_buf,sizeof rx_buf,RECEIVE_TIMEOUT);
+		uart_rx_enable(dev ,rx_buf,RECEIVE_BUFF_SIZE,RECEIVE_TIMEOUT);
 	break;
 		
 	default:
 	break;
 	}
+
+	SB_TRACE_END(SB_TRACE_UART_CB, evt->type);
+}
+
+/* Number the score with crdt_seq() and add its change to the history,
+ * observers that missed the last changes recover them from any later
+ * report. A change of several steps, or several changes merged at once,
+ * skips sequences: the score stayed the same over them, SB_HISTORY_SAME.
+ * Only published when the score or the epoch changed, otherwise the
+ * controller would pick a new DID for identical data.
+ */
+static void adv_payload_update(const struct sb_score *score)
+{
+	struct sb_score_adv payload;
+	uint16_t seq = crdt_seq();
+	uint8_t epoch = crdt_epoch();
+	size_t shift;
+
+	zbus_chan_read(&adv_payload_chan, &payload, K_FOREVER);
+	if ((memcmp(&payload.score, score, sizeof(*score)) == 0) && (payload.epoch == epoch)) {
+		return;
+	}
+
+	shift = MIN((uint16_t)(seq - sys_le16_to_cpu(payload.seq)), SB_SCORE_HISTORY_LEN);
+	if (shift > 0) {
+		memmove(&payload.history[shift], &payload.history[0],
+			sizeof(payload.history) - shift);
+		memset(&payload.history[1], SB_HISTORY_SAME, shift - 1);
+		payload.history[0] = sb_history_encode(&payload.score, score);
+	}
+
+	payload.score = *score;
+	payload.seq = sys_cpu_to_le16(seq);
+	payload.epoch = epoch;
+
+	sb_chan_pub(&adv_payload_chan, &payload, K_FOREVER);
+}
+
+/* Listener of score_chan */
+static void adv_payload_build(const struct zbus_channel *chan)
+{
+	adv_payload_update(zbus_chan_const_msg(chan));
+}
+
+ZBUS_LISTENER_DEFINE(adv_payload_lis, adv_payload_build);
+
+/* Set the epoch drawn at this boot, before the first advertisement.
+ * Observers take the sequences that start over with it as a restart, not
+ * as stale scores still relayed from before it.
+ */
+static int adv_epoch_init(void)
+{
+	struct sb_score_adv *payload;
+	int err;
+
+	err = zbus_chan_claim(&adv_payload_chan, K_FOREVER);
+	if (err) {
+		return err;
+	}
+
+	payload = zbus_chan_msg(&adv_payload_chan);
+	payload->epoch = crdt_epoch();
+	adv_mfg_data.epoch = payload->epoch;
+
+	return zbus_chan_finish(&adv_payload_chan);
+}
+
+/* Copies the score of adv_mfg_data to the legacy set */
+static int legacy_adv_update(void)
+{
+	legacy_data.home_points = MIN(sys_le16_to_cpu(adv_mfg_data.team_home_points), UINT8_MAX);
+	legacy_data.guest_points = MIN(sys_le16_to_cpu(adv_mfg_data.team_guest_points), UINT8_MAX);
+	legacy_data.home_sets = adv_mfg_data.team_home_set;
+	legacy_data.guest_sets = adv_mfg_data.team_guest_set;
+	legacy_data.serving = adv_mfg_data.serving;
+
+	return bt_le_ext_adv_set_data(legacy_adv, legacy_ad, ARRAY_SIZE(legacy_ad), NULL, 0);
+}
+
+/* Listener of adv_payload_chan, added after the GATT and PAwR listeners so
+ * that connected observers get a notification first
+ */
+static void adv_set_update(const struct zbus_channel *chan)
+{
+	int err;
+
+	memcpy(&adv_mfg_data, zbus_chan_const_msg(chan), sizeof(adv_mfg_data));
+
+	SB_TRACE_BEGIN(SB_TRACE_ADV_UPDATE, SB_ADV_SID_SCORE);
+	err = bt_le_ext_adv_set_data(adv, ad, ARRAY_SIZE(ad), NULL, 0);
+	SB_TRACE_END(SB_TRACE_ADV_UPDATE, SB_ADV_SID_SCORE);
+	if (err) {
+		LOG_ERR("Failed to update advertising data (err %d)", err);
+		return;
+	}
+
+	STATS_INC(adv_score_updates);
+	STATS_HIST(adv_airtime_us, phy_adv_event_airtime_us(ad, ARRAY_SIZE(ad)));
+
+	if (IS_ENABLED(CONFIG_SCOREBOARD_LEGACY_ADV)) {
+		err = legacy_adv_update();
+		if (err) {
+			LOG_ERR("Failed to update legacy advertising data (err %d)", err);
+		}
+	}
+}
+
+ZBUS_LISTENER_DEFINE(adv_set_lis, adv_set_update);
+
+/* Publish the score if it changed */
+static void score_publish(const struct sb_score *before, const struct sb_score *score)
+{
+	if (memcmp(before, score, sizeof(*score)) != 0) {
+		sb_chan_pub(&score_chan, score, K_FOREVER);
+	}
+}
+
+/* Same as adv_payload_build() and adv_set_update() for the match record set */
+static int update_match_adv_data(void)
+{
+	int err;
+
+	match_data_len = match_encode(match_data, sizeof(match_data));
+
+	if ((match_data_len == match_data_sent_len) &&
+	    (memcmp(match_data_sent, match_data, match_data_len) == 0)) {
+		return 0;
+	}
+
+	match_ad[2].data_len = match_data_len;
+
+	SB_TRACE_BEGIN(SB_TRACE_ADV_UPDATE, SB_ADV_SID_MATCH);
+	err = bt_le_ext_adv_set_data(match_adv, match_ad, ARRAY_SIZE(match_ad), NULL, 0);
+	SB_TRACE_END(SB_TRACE_ADV_UPDATE, SB_ADV_SID_MATCH);
+	if (err) {
+		LOG_ERR("Failed to update match record (err %d)", err);
+		return err;
+	}
+
+	memcpy(match_data_sent, match_data, match_data_len);
+	match_data_sent_len = match_data_len;
+	STATS_INC(adv_match_updates);
+	STATS_HIST(match_airtime_us, phy_adv_event_airtime_us(match_ad, ARRAY_SIZE(match_ad)));
+
+	return 0;
+}
+
+/* Stops the clock at zero and re-anchors it, see match_clock_tick() */
+static void clock_work_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	uint32_t now_ms = k_uptime_get_32();
+	int32_t next_ms;
+
+	k_mutex_lock(&match_lock, K_FOREVER);
+	if (match_clock_tick(now_ms)) {
+		update_match_adv_data();
+	}
+	next_ms = match_clock_next_event_ms(now_ms);
+	k_mutex_unlock(&match_lock);
+
+	if (next_ms >= 0) {
+		k_work_reschedule(dwork, K_MSEC(next_ms));
+	}
+}
+
+static K_WORK_DELAYABLE_DEFINE(clock_work, clock_work_handler);
+
+/* Take back the newest command not undone yet, given by any voice input.
+ * Its change of the score is reverted by the replica that made it, so points
+ * other replicas scored since stay. Timeouts and fouls are counted back
+ * here. A command whose match record change cannot be taken back, such as
+ * a new period, stays on the undo chain and nothing changes.
+ *
+ * @param match_changed Set if the match record changed.
+ *
+ * @return The command was taken back.
+ */
+static bool undo_last(struct sb_score *score, bool *match_changed)
+{
+	struct journal_entry undone;
+
+	if (journal_undo_peek(&undone) != 0) {
+		LOG_INF("Nothing to undo");
+		return false;
+	}
+
+	*match_changed = (undone.flags & JOURNAL_MATCH) != 0;
+	if (*match_changed) {
+		bool taken_back;
+
+		k_mutex_lock(&match_lock, K_FOREVER);
+		taken_back = match_undo_cmd(undone.cmd);
+		if (taken_back) {
+			update_match_adv_data();
+		}
+		k_mutex_unlock(&match_lock);
+
+		if (!taken_back) {
+			LOG_WRN("Command 0x%02x: match record cannot be taken back", undone.cmd);
+			return false;
+		}
+	}
+
+	(void)journal_undo(&undone);
+	LOG_INF("Undo command 0x%02x of replica %u", undone.cmd, JOURNAL_SOURCE(undone.flags));
+
+	crdt_apply_change(JOURNAL_SOURCE(undone.flags), &undone.after, &undone.before);
+	crdt_score(score);
+
+	return true;
+}
+
+/* A command frame that repeats one accepted from the same voice input, see
+ * dedupe_drop(). Checked before anything else in the dispatch.
+ */
+static bool voice_frame_duplicate(const struct voice_frame *frame)
+{
+	const uint8_t *rx_buf = frame->data;
+
+	if ((rx_buf[0] != 0xF4) || (rx_buf[1] != 0xF5) || (rx_buf[2] != 0x03)) {
+		return false;
+	}
+
+	return dedupe_drop(&dedupe[frame->source], rx_buf[7], rx_buf[6], k_uptime_get_32());
+}
+
+/* Merge the replicas heard from peer broadcasters and show the score, one
+ * journal entry per replica that grew. Runs before every command, so that
+ * the score before and after a command only differ by that command.
+ */
+static void peers_merge(void)
+{
+	struct sb_crdt_replica heard[CONFIG_SCOREBOARD_CRDT_REPLICAS];
+	bool epoch_grew;
+	bool merged;
+	uint8_t epoch;
+	size_t count;
+
+	if (!IS_ENABLED(CONFIG_SCOREBOARD_CRDT_PEERS)) {
+		return;
+	}
+
+	/* The epoch first, so that the scores merged are published with it */
+	count = peer_take(heard, ARRAY_SIZE(heard), &epoch);
+	epoch_grew = crdt_merge_epoch(epoch);
+	merged = epoch_grew;
+
+	for (size_t i = 0; i < count; i++) {
+		struct sb_score before;
+		struct sb_score score;
+		int ret = crdt_merge(&heard[i]);
+
+		if (ret == -EPERM) {
+			STATS_INC(crdt_own_rejects);
+			LOG_WRN("Peer holds replica %u ahead of this broadcaster, "
+				"check CONFIG_SCOREBOARD_REPLICA_BASE", heard[i].id);
+			continue;
+		}
+
+		if (ret == -ENOMEM) {
+			STATS_INC(crdt_dropped);
+			LOG_WRN("No room for replica %u, raise CONFIG_SCOREBOARD_CRDT_REPLICAS",
+				heard[i].id);
+			continue;
+		}
+
+		if (ret == 0) {
+			continue;
+		}
+
+		if ((heard[i].id >= CONFIG_SCOREBOARD_REPLICA_BASE) &&
+		    (heard[i].id < CONFIG_SCOREBOARD_REPLICA_BASE + ARRAY_SIZE(voice_uarts))) {
+			STATS_INC(crdt_own_adopted);
+		}
+
+		STATS_INC(crdt_merges);
+		merged = true;
+
+		zbus_chan_read(&score_chan, &before, K_FOREVER);
+		score = before;
+		crdt_score(&score);
+		journal_append(JOURNAL_CMD_MERGE, heard[i].id, &before, &score, false);
+		score_publish(&before, &score);
+	}
+
+	/* A new epoch with the same score is advertised all the same */
+	if (epoch_grew) {
+		struct sb_score score;
+
+		zbus_chan_read(&score_chan, &score, K_FOREVER);
+		adv_payload_update(&score);
+	}
+
+	/* Pass the replicas on to peers out of range of this one */
+	if (merged) {
+		peer_update();
+	}
+}
+
+/* Hear the peers for CONFIG_SCOREBOARD_CRDT_JOIN_MS before the voice inputs
+ * are enabled, so that the local replicas take back their counts from the
+ * peers' copies after a restart, see crdt.c.
+ */
+static void peers_join(void)
+{
+	int64_t end = k_uptime_get() + CONFIG_SCOREBOARD_CRDT_JOIN_MS;
+	struct voice_frame frame;
+
+	/* Only peer_heard() queues frames before the UARTs are enabled */
+	while (k_msgq_get(&voice_msgq, &frame, K_TIMEOUT_ABS_MS(end)) == 0) {
+		peers_merge();
+	}
+
+	crdt_join_end();
+}
+
+/* Listener of voice_cmd_chan, applies a command word in thread0. The
+ * command is an operation of the replica of its voice input, applied to
+ * the merged score.
+ */
+static void score_dispatch(const struct zbus_channel *chan)
+{
+	const struct voice_cmd *cmd = zbus_chan_const_msg(chan);
+	uint8_t replica = CONFIG_SCOREBOARD_REPLICA_BASE + cmd->source;
+	struct sb_score before;
+	struct sb_score score;
+	bool match_changed;
+
+	peers_merge();
+
+	zbus_chan_read(&score_chan, &before, K_FOREVER);
+	score = before;
+
+	if (cmd->cmd == SCORE_UNDO_LAST) {
+		if (undo_last(&score, &match_changed)) {
+			journal_append(SCORE_UNDO_LAST, replica, &before, &score, match_changed);
+		}
+	} else {
+		crdt_apply_cmd(replica, cmd->cmd);
+		crdt_score(&score);
+
+		if (cmd->cmd == NEXT_PERIOD) {
+			uint32_t adv_updates = stats.adv_score_updates + stats.adv_match_updates;
+
+			LOG_INF("Period %u: %u advertising updates",
+				match_period(), adv_updates - period_adv_update_base);
+			period_adv_update_base = adv_updates;
+		}
+
+		k_mutex_lock(&match_lock, K_FOREVER);
+		match_changed = match_apply_cmd(cmd->cmd);
+		if (match_changed) {
+			update_match_adv_data();
+		}
+		k_mutex_unlock(&match_lock);
+		k_work_reschedule(&clock_work, K_NO_WAIT);
+
+		journal_append(cmd->cmd, replica, &before, &score, match_changed);
+
+		/* Keep the log of a finished period */
+		if (cmd->cmd == NEXT_PERIOD) {
+			journal_flush();
+		}
+	}
+
+	score_publish(&before, &score);
+
+	if (IS_ENABLED(CONFIG_SCOREBOARD_CRDT_PEERS)) {
+		peer_update();
+	}
+}
+
+ZBUS_LISTENER_DEFINE(dispatch_lis, score_dispatch);
+
+/* Peer replicas are waiting for peers_merge(), from the BT RX thread */
+static void peer_heard(void)
+{
+	struct voice_frame frame = {.source = VOICE_SOURCE_PEER};
+
+	/* A full queue is busy anyway, the next command merges them */
+	(void)k_msgq_put(&voice_msgq, &frame, K_NO_WAIT);
 }
 
 /* Add the definition of callback function and update the advertising data dynamically */
@@ -154,6 +649,7 @@ static int init_button(void)
 
 int thread0(void)
 {	
+	uint8_t flag = 0;
 	int err;
 
 	/* Setup leds on your board  */
@@ -168,16 +664,24 @@ int thread0(void)
 		return -1;
 	}
 
-	/* Verify that the UART device is ready */ 
-	if (!device_is_ready(uart)){		
-		return -1;
+	for (size_t i = 0; i < ARRAY_SIZE(voice_uarts); i++) {
+		/* Verify that the UART device is ready */
+		if (!device_is_ready(voice_uarts[i])) {
+			return -1;
+		}
+
+		/* Register the UART callback function */
+		err = uart_callback_set(voice_uarts[i], uart_cb, (void *)i);
+		if (err) {
+			return -1;
+		}
 	}
 
-	/* Register the UART callback function */
-	err = uart_callback_set(uart, uart_cb, NULL);
+	/* One replica per voice input, peers add theirs */
+	err = crdt_init(CONFIG_SCOREBOARD_REPLICA_BASE, ARRAY_SIZE(voice_uarts), sys_rand32_get());
 	if (err) {
 		return -1;
-	}	
+	}
 
 	/* Bluetooth enable */
 	err = bt_enable(NULL);
@@ -185,132 +689,153 @@ int thread0(void)
 		return -1;
 	}	
 
-	err = bt_le_adv_start(adv_param, ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
+	err = adv_epoch_init();
+	if (err) {
+		return -1;
+	}
+
+	err = bt_le_ext_adv_create(adv_param, NULL, &adv);
+	if (err) {
+		return -1;
+	}
+
+	err = bt_le_ext_adv_set_data(adv, ad, ARRAY_SIZE(ad), NULL, 0);
+	if (err) {
+		return -1;
+	}
+
+	err = bt_le_ext_adv_start(adv, BT_LE_EXT_ADV_START_DEFAULT);
 	if (err) {		
 		return -1;
 	}	
 
-	err = uart_rx_enable(uart ,rx_buf, 13,RECEIVE_TIMEOUT);
-	if (err) {			
+	if (IS_ENABLED(CONFIG_SCOREBOARD_LEGACY_ADV)) {
+		err = bt_le_ext_adv_create(&legacy_adv_param, NULL, &legacy_adv);
+		if (err) {
+			return -1;
+		}
+
+		err = legacy_adv_update();
+		if (err) {
+			return -1;
+		}
+
+		err = bt_le_ext_adv_start(legacy_adv, BT_LE_EXT_ADV_START_DEFAULT);
+		if (err) {
+			return -1;
+		}
+	}
+
+	err = bt_le_ext_adv_create(&match_adv_param, NULL, &match_adv);
+	if (err) {
 		return -1;
-	}	
+	}
+
+	err = update_match_adv_data();
+	if (err) {
+		return -1;
+	}
+
+	err = bt_le_ext_adv_start(match_adv, BT_LE_EXT_ADV_START_DEFAULT);
+	if (err) {
+		return -1;
+	}
+
+	LOG_INF("Advertising on %s PHY, score event %u us, match event %u us on air",
+		phy_name(), phy_adv_event_airtime_us(ad, ARRAY_SIZE(ad)),
+		phy_adv_event_airtime_us(match_ad, ARRAY_SIZE(match_ad)));
+
+	if (IS_ENABLED(CONFIG_SCOREBOARD_GATT)) {
+		err = gatt_init(&adv_mfg_data, sizeof(adv_mfg_data));
+		if (err) {
+			return -1;
+		}
+	}
+
+	if (IS_ENABLED(CONFIG_SCOREBOARD_PAWR)) {
+		err = pawr_init(&adv_mfg_data, sizeof(adv_mfg_data));
+		if (err) {
+			return -1;
+		}
+	}
+
+	/* After the GATT and PAwR listeners */
+	err = zbus_chan_add_obs(&adv_payload_chan, &adv_set_lis, K_FOREVER);
+	if (err) {
+		return -1;
+	}
+
+	if (IS_ENABLED(CONFIG_SCOREBOARD_CRDT_PEERS)) {
+		err = peer_init(peer_heard);
+		if (err) {
+			return -1;
+		}
+
+		peers_join();
+	} else {
+		crdt_join_end();
+	}
+
+	/* The scoreboard runs on without the flash log */
+	err = journal_init();
+	if (err) {
+		LOG_ERR("Journal flash log not available (err %d)", err);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(voice_uarts); i++) {
+		err = uart_rx_enable(voice_uarts[i], rx_bufs[i], RECEIVE_BUFF_SIZE, RECEIVE_TIMEOUT);
+		if (err) {
+			return -1;
+		}
+	}
 
 	while(1)
 	{		
-		k_sem_take(&sem, K_FOREVER);
-		if(DF2301Q_CMD == 1)
+		struct voice_frame frame;
+
+		k_msgq_get(&voice_msgq, &frame, K_FOREVER);
+		if(frame.source == VOICE_SOURCE_PEER)
+		{
+			peers_merge();
+		}
+		else if(voice_frame_duplicate(&frame))
 		{
-			DF2301Q_CMD = 0;
+			/* Nothing changed, no advertising or LED update */
+		}
+		else
+		{
+			uint32_t dispatch_start_cyc = k_cycle_get_32();
+			uint8_t *rx_buf = frame.data;
+			uint8_t cmd_id = rx_buf[7];
+
+			SB_TRACE_BEGIN(SB_TRACE_DISPATCH, cmd_id);
+
+			/* Frame activity LED */
+			if(flag == 0)
+			{
+				dk_set_led(DK_LED3, 1);	
+				flag = 1;
+			}
+			else if(flag == 1)
+			{
+				dk_set_led(DK_LED3, 0);
+				flag = 0;
+			}	
+
 			if((rx_buf[0] == 0xF4) && (rx_buf[1] == 0xF5))
 			{			
+				STATS_INC(cmds_dispatched);
+
 				if(rx_buf[2] == 0x03)
 				{				
-					if(rx_buf[7] == TEAM_HOME_PLUS_ONE_POINT)	
-					{
-						if(adv_mfg_data.team_home_points == 99)
-						{
-							adv_mfg_data.team_home_points = 99;
-						}
-						else
-						{
-							adv_mfg_data.team_home_points += 1; 
-						}
-					}
-					else if(rx_buf[7] == TEAM_HOME_MINUS_ONE_POINT)	
-					{
-						if(adv_mfg_data.team_home_points == 0)
-						{
-							adv_mfg_data.team_home_points = 0;
-						}
-						else
-						{
-							adv_mfg_data.team_home_points -= 1; 
-						}
-					}	
-					else if(rx_buf[7] == TEAM_GUEST_PLUS_ONE_POINT)	
-					{
-						if(adv_mfg_data.team_guest_points == 99)
-						{
-							adv_mfg_data.team_guest_points = 99;
-						}
-						else
-						{
-							adv_mfg_data.team_guest_points += 1; 
-						}
-					}	
-					else if(rx_buf[7] == TEAM_GUEST_MINUS_ONE_POINT)	
-					{
-						if(adv_mfg_data.team_guest_points == 0)
-						{
-							adv_mfg_data.team_guest_points = 0;
-						}
-						else
-						{
-							adv_mfg_data.team_guest_points -= 1; 
-						}
-					}	
-					else if(rx_buf[7] == TEAM_HOME_PLUS_ONE_SET)	
-					{
-						if(adv_mfg_data.team_home_set == 9)
-						{
-							adv_mfg_data.team_home_set = 9;
-						}
-						else
-						{
-							adv_mfg_data.team_home_set += 1; 
-						}
-					}	
-					else if(rx_buf[7] == TEAM_HOME_MINUS_ONE_SET)	
-					{
-						if(adv_mfg_data.team_home_set == 0)
-						{
-							adv_mfg_data.team_home_set = 0;
-						}
-						else
-						{
-							adv_mfg_data.team_home_set -= 1; 
-						}
-					}	
-					else if(rx_buf[7] == TEAM_GUEST_PLUS_ONE_SET)	
-					{
-						if(adv_mfg_data.team_guest_set == 9)
-						{
-							adv_mfg_data.team_guest_set = 9;
-						}
-						else
-						{
-							adv_mfg_data.team_guest_set += 1; 
-						}
-					}	
-					else if(rx_buf[7] == TEAM_GUEST_MINUS_ONE_SET)	
-					{
-						if(adv_mfg_data.team_guest_set == 0)
-						{
-							adv_mfg_data.team_guest_set = 0;
-						}
-						else
-						{
-							adv_mfg_data.team_guest_set -= 1; 
-						}
-					}
-					else if(rx_buf[7] == TEAM_HOME_SERVING)	
-					{
-						adv_mfg_data.serving |= 1 << TEAM_HOME_SERVING_BIT;
-						adv_mfg_data.serving &= ~(1 << TEAM_GUEST_SERVING_BIT);						
-					}	
-					else if(rx_buf[7] == TEAM_GUEST_SERVING)	
-					{
-						adv_mfg_data.serving |= 1 << TEAM_GUEST_SERVING_BIT;
-						adv_mfg_data.serving &= ~(1 << TEAM_HOME_SERVING_BIT);	
-					}
-					else if(rx_buf[7] == SCORE_BOARD_RESET)	
-					{
-						adv_mfg_data.team_home_points = 0;
-						adv_mfg_data.team_guest_points = 0;
-						adv_mfg_data.team_home_set = 0;
-						adv_mfg_data.team_guest_set = 0;
-						adv_mfg_data.serving = 0;
-					}
+					struct voice_cmd cmd = {
+						.source = frame.source,
+						.cmd = rx_buf[7],
+						.seq = rx_buf[6],
+					};
+
+					/* The dispatch and every consumer attached listen */
+					sb_chan_pub(&voice_cmd_chan, &cmd, K_FOREVER);
 				}
 				else if(rx_buf[2] == 0x02)
 				{
@@ -318,9 +843,13 @@ int thread0(void)
 					dk_set_led(DK_LED2, 0);					
 				}	
 
-				bt_le_adv_update_data(ad, ARRAY_SIZE(ad), sd, ARRAY_SIZE(sd));
-				memset(rx_buf, 0, sizeof(rx_buf));				
+				STATS_HIST(cmd_dispatch_us, k_cyc_to_us_floor32(k_cycle_get_32() - dispatch_start_cyc));
+			}
+			else
+			{
+				STATS_INC(cmd_bad_header);
 			}
+			SB_TRACE_END(SB_TRACE_DISPATCH, cmd_id);
 			//k_sleep(K_MSEC(500));
 		}		
 	}
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include <scoreboard_proto.h>
+#include "df2301q.h"
+#include "match.h"
+
+#define COMPANY_ID_CODE 0x0059 // Nordic BLE ID
+
+#define TIMEOUTS_MAX 9
+#define FOULS_MAX    99
+#define PERIOD_MAX   9
+
+BUILD_ASSERT(sizeof(CONFIG_SCOREBOARD_TEAM_HOME_NAME) - 1 <= SB_TEAM_NAME_MAX_LEN);
+BUILD_ASSERT(sizeof(CONFIG_SCOREBOARD_TEAM_GUEST_NAME) - 1 <= SB_TEAM_NAME_MAX_LEN);
+BUILD_ASSERT(sizeof(CONFIG_SCOREBOARD_MESSAGE) - 1 <= SB_MESSAGE_MAX_LEN);
+
+static const char home_name[] = CONFIG_SCOREBOARD_TEAM_HOME_NAME;
+static const char guest_name[] = CONFIG_SCOREBOARD_TEAM_GUEST_NAME;
+static const char message[] = CONFIG_SCOREBOARD_MESSAGE;
+static const uint8_t team_colors[] = {
+	(CONFIG_SCOREBOARD_TEAM_HOME_COLOR >> 16) & 0xFF,
+	(CONFIG_SCOREBOARD_TEAM_HOME_COLOR >> 8) & 0xFF,
+	CONFIG_SCOREBOARD_TEAM_HOME_COLOR & 0xFF,
+	(CONFIG_SCOREBOARD_TEAM_GUEST_COLOR >> 16) & 0xFF,
+	(CONFIG_SCOREBOARD_TEAM_GUEST_COLOR >> 8) & 0xFF,
+	CONFIG_SCOREBOARD_TEAM_GUEST_COLOR & 0xFF,
+};
+
+#define CLOCK_PERIOD_DS (CONFIG_SCOREBOARD_CLOCK_PERIOD_S * 10)
+#define CLOCK_ADJUST_DS 10
+
+static uint8_t timeouts[2];
+static uint8_t fouls[2];
+static uint8_t period = 1;
+
+static struct sb_clock_anchor clock = {
+	.flags = IS_ENABLED(CONFIG_SCOREBOARD_CLOCK_COUNT_UP) ? 0 : SB_CLOCK_FLAG_COUNT_DOWN,
+	.value_ds = IS_ENABLED(CONFIG_SCOREBOARD_CLOCK_COUNT_UP) ? 0 : CLOCK_PERIOD_DS,
+	.rate = SB_CLOCK_RATE_REALTIME,
+};
+
+static bool inc_saturated(uint8_t *val, uint8_t max)
+{
+	if (*val >= max) {
+		return false;
+	}
+
+	(*val)++;
+
+	return true;
+}
+
+static bool dec_saturated(uint8_t *val)
+{
+	if (*val == 0) {
+		return false;
+	}
+
+	(*val)--;
+
+	return true;
+}
+
+/* Clock value in tenths of a second at uptime now_ms */
+static uint32_t clock_value(uint32_t now_ms)
+{
+	uint32_t elapsed_ds;
+
+	if (!(clock.flags & SB_CLOCK_FLAG_RUNNING)) {
+		return clock.value_ds;
+	}
+
+	elapsed_ds = (uint64_t)(now_ms - clock.anchor_ms) * clock.rate /
+		     (100U * SB_CLOCK_RATE_REALTIME);
+
+	if (!(clock.flags & SB_CLOCK_FLAG_COUNT_DOWN)) {
+		return clock.value_ds + elapsed_ds;
+	}
+
+	return (elapsed_ds >= clock.value_ds) ? 0 : clock.value_ds - elapsed_ds;
+}
+
+/* Move the anchor to now_ms, keeping the displayed value */
+static void clock_anchor(uint32_t now_ms)
+{
+	clock.value_ds = clock_value(now_ms);
+	clock.anchor_ms = now_ms;
+}
+
+static void clock_reset(void)
+{
+	clock.flags &= ~SB_CLOCK_FLAG_RUNNING;
+	clock.value_ds = (clock.flags & SB_CLOCK_FLAG_COUNT_DOWN) ? CLOCK_PERIOD_DS : 0;
+	clock.anchor_ms = k_uptime_get_32();
+}
+
+static bool clock_apply_cmd(uint8_t cmd)
+{
+	uint32_t now_ms = k_uptime_get_32();
+	bool running = clock.flags & SB_CLOCK_FLAG_RUNNING;
+
+	switch (cmd) {
+	case CLOCK_START:
+		if (running) {
+			return false;
+		}
+		clock_anchor(now_ms);
+		clock.flags |= SB_CLOCK_FLAG_RUNNING;
+		return true;
+	case CLOCK_STOP:
+		if (!running) {
+			return false;
+		}
+		clock_anchor(now_ms);
+		clock.flags &= ~SB_CLOCK_FLAG_RUNNING;
+		return true;
+	case CLOCK_RESET:
+		clock_reset();
+		return true;
+	case CLOCK_PLUS_ONE_SECOND:
+		clock_anchor(now_ms);
+		clock.value_ds += CLOCK_ADJUST_DS;
+		return true;
+	case CLOCK_MINUS_ONE_SECOND:
+		clock_anchor(now_ms);
+		clock.value_ds -= MIN(clock.value_ds, CLOCK_ADJUST_DS);
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool match_clock_tick(uint32_t now_ms)
+{
+	if (!(clock.flags & SB_CLOCK_FLAG_RUNNING)) {
+		return false;
+	}
+
+	if ((clock.flags & SB_CLOCK_FLAG_COUNT_DOWN) && (clock_value(now_ms) == 0)) {
+		clock_anchor(now_ms);
+		clock.flags &= ~SB_CLOCK_FLAG_RUNNING;
+		return true;
+	}
+
+	if ((CONFIG_SCOREBOARD_CLOCK_REANCHOR_S > 0) &&
+	    ((now_ms - clock.anchor_ms) >= CONFIG_SCOREBOARD_CLOCK_REANCHOR_S * MSEC_PER_SEC)) {
+		clock_anchor(now_ms);
+		return true;
+	}
+
+	return false;
+}
+
+int32_t match_clock_next_event_ms(uint32_t now_ms)
+{
+	uint32_t next_ms = UINT32_MAX;
+
+	if (!(clock.flags & SB_CLOCK_FLAG_RUNNING)) {
+		return -1;
+	}
+
+	if (clock.flags & SB_CLOCK_FLAG_COUNT_DOWN) {
+		/* Anchor relative time at which the value reaches zero */
+		next_ms = (uint64_t)clock.value_ds * 100U * SB_CLOCK_RATE_REALTIME / clock.rate;
+	}
+
+	if (CONFIG_SCOREBOARD_CLOCK_REANCHOR_S > 0) {
+		next_ms = MIN(next_ms, CONFIG_SCOREBOARD_CLOCK_REANCHOR_S * MSEC_PER_SEC);
+	}
+
+	next_ms -= MIN(next_ms, now_ms - clock.anchor_ms);
+
+	return (int32_t)MIN(next_ms, INT32_MAX);
+}
+
+uint8_t match_period(void)
+{
+	return period;
+}
+
+void match_reset(void)
+{
+	memset(timeouts, 0, sizeof(timeouts));
+	memset(fouls, 0, sizeof(fouls));
+	period = 1;
+	clock_reset();
+}
+
+bool match_apply_cmd(uint8_t cmd)
+{
+	switch (cmd) {
+	case TEAM_HOME_PLUS_ONE_TIMEOUT:
+		return inc_saturated(&timeouts[0], TIMEOUTS_MAX);
+	case TEAM_GUEST_PLUS_ONE_TIMEOUT:
+		return inc_saturated(&timeouts[1], TIMEOUTS_MAX);
+	case TEAM_HOME_PLUS_ONE_FOUL:
+		return inc_saturated(&fouls[0], FOULS_MAX);
+	case TEAM_GUEST_PLUS_ONE_FOUL:
+		return inc_saturated(&fouls[1], FOULS_MAX);
+	case NEXT_PERIOD:
+		if (!inc_saturated(&period, PERIOD_MAX)) {
+			return false;
+		}
+		/* Team fouls count per period, the clock restarts */
+		memset(fouls, 0, sizeof(fouls));
+		clock_reset();
+		return true;
+	case SCORE_BOARD_RESET:
+		match_reset();
+		return true;
+	default:
+		return clock_apply_cmd(cmd);
+	}
+}
+
+bool match_undo_cmd(uint8_t cmd)
+{
+	switch (cmd) {
+	case TEAM_HOME_PLUS_ONE_TIMEOUT:
+		return dec_saturated(&timeouts[0]);
+	case TEAM_GUEST_PLUS_ONE_TIMEOUT:
+		return dec_saturated(&timeouts[1]);
+	case TEAM_HOME_PLUS_ONE_FOUL:
+		return dec_saturated(&fouls[0]);
+	case TEAM_GUEST_PLUS_ONE_FOUL:
+		return dec_saturated(&fouls[1]);
+	default:
+		return false;
+	}
+}
+
+size_t match_encode(uint8_t *buf, size_t size)
+{
+	struct sb_clock_anchor anchor = {
+		.flags = clock.flags,
+		.value_ds = sys_cpu_to_le32(clock.value_ds),
+		.anchor_ms = sys_cpu_to_le32(clock.anchor_ms),
+		.rate = sys_cpu_to_le16(clock.rate),
+	};
+	size_t off = 0;
+	bool ok;
+
+	if (size < 3) {
+		return 0;
+	}
+
+	sys_put_le16(COMPANY_ID_CODE, buf);
+	buf[2] = SB_MATCH_RECORD_ID;
+	off = 3;
+
+	ok = sb_tlv_put(buf, size, &off, SB_TLV_TEAM_HOME_NAME,
+			home_name, sizeof(home_name) - 1);
+	ok = ok && sb_tlv_put(buf, size, &off, SB_TLV_TEAM_GUEST_NAME,
+			      guest_name, sizeof(guest_name) - 1);
+	ok = ok && sb_tlv_put(buf, size, &off, SB_TLV_TEAM_COLORS,
+			      team_colors, sizeof(team_colors));
+	ok = ok && sb_tlv_put(buf, size, &off, SB_TLV_TIMEOUTS,
+			      timeouts, sizeof(timeouts));
+	ok = ok && sb_tlv_put(buf, size, &off, SB_TLV_FOULS,
+			      fouls, sizeof(fouls));
+	ok = ok && sb_tlv_put(buf, size, &off, SB_TLV_PERIOD,
+			      &period, sizeof(period));
+	ok = ok && sb_tlv_put(buf, size, &off, SB_TLV_CLOCK,
+			      &anchor, sizeof(anchor));
+	if (sizeof(message) > 1) {
+		ok = ok && sb_tlv_put(buf, size, &off, SB_TLV_MESSAGE,
+				      message, sizeof(message) - 1);
+	}
+	__ASSERT(ok, "Match record buffer too small");
+
+	return off;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef MATCH_H_
+#define MATCH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Reset timeouts, fouls and period. Team names are kept. */
+void match_reset(void);
+
+/**
+ * @brief Apply a DF2301Q command word to the match record.
+ *
+ * @param cmd Command word ID.
+ *
+ * @return true if the match record changed.
+ */
+bool match_apply_cmd(uint8_t cmd);
+
+/**
+ * @brief Take back a command word that changed the match record.
+ *
+ * Timeouts and fouls are counted back. Period, clock and reset commands
+ * cannot be taken back.
+ *
+ * @param cmd Command word ID given to match_apply_cmd().
+ *
+ * @return true if the match record changed.
+ */
+bool match_undo_cmd(uint8_t cmd);
+
+/**
+ * @brief Run the match clock housekeeping.
+ *
+ * Stops a count down clock at zero and re-anchors a running clock every
+ * CONFIG_SCOREBOARD_CLOCK_REANCHOR_S seconds so observers can correct drift.
+ *
+ * @param now_ms Current uptime in milliseconds.
+ *
+ * @return true if the clock anchor changed.
+ */
+bool match_clock_tick(uint32_t now_ms);
+
+/**
+ * @brief Time until match_clock_tick() has work to do.
+ *
+ * @param now_ms Current uptime in milliseconds.
+ *
+ * @return Milliseconds until the next clock event, -1 if the clock is stopped.
+ */
+int32_t match_clock_next_event_ms(uint32_t now_ms);
+
+/** @brief Current match period, starting at 1. */
+uint8_t match_period(void);
+
+/**
+ * @brief Encode the match record as manufacturer data.
+ *
+ * The output is the company ID, SB_MATCH_RECORD_ID and the TLVs.
+ *
+ * @param buf Output buffer.
+ * @param size Size of @p buf.
+ *
+ * @return Number of bytes written.
+ */
+size_t match_encode(uint8_t *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MATCH_H_ */
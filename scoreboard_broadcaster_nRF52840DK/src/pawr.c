@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Periodic advertising with responses (PAwR).
+ *
+ * Every periodic event carries the score and its sequence number in the
+ * score subevent. Each display answers in the response slot of its display
+ * ID with the sequence it shows, so the broadcaster knows which displays
+ * are behind. While one is behind for longer than the normal delivery
+ * time, the score is repeated in the retry subevent of the same event. The
+ * retry subevent is empty otherwise and costs no airtime.
+ *
+ * A new score is shown by all displays at the same instant, the anchor of
+ * the periodic event CONFIG_SCOREBOARD_PAWR_APPLY_EVENTS after the one that
+ * first carries it. Each subevent tells how many events are left, which
+ * every display turns into a local time from when it received it. The
+ * displays report how late they started the strip update after their own
+ * estimate of that instant. The spread of those is the commit jitter, which
+ * leaves out how far each estimate is off the real anchor, so it is not the
+ * skew between displays.
+ *
+ * The controller asks for subevent data a few events ahead, from the
+ * Bluetooth RX thread, which also reports the responses. The score is
+ * written by thread0.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/zbus/zbus.h>
+#include <string.h>
+#include <scoreboard_proto.h>
+#include "channels.h"
+#include "pawr.h"
+#include "stats.h"
+
+LOG_MODULE_DECLARE(Scoreboard, LOG_LEVEL_INF);
+
+#define COMPANY_ID_CODE 0x0059 // Nordic BLE ID
+
+#define NUM_SLOTS CONFIG_SCOREBOARD_PAWR_DISPLAYS
+
+/* Periodic interval in 1.25 ms units, the two subevents split it evenly */
+#define PER_INTERVAL      (CONFIG_SCOREBOARD_PAWR_INTERVAL_MS * 4 / 5)
+#define SUBEVENT_INTERVAL (PER_INTERVAL / SB_PAWR_NUM_SUBEVENTS)
+#define RSP_SLOT_DELAY    1 /* 1.25 ms after the subevent, in 1.25 ms units */
+#define RSP_SLOT_SPACING  4 /* 0.5 ms, in 0.125 ms units */
+
+/* The response slots of a subevent end before the next subevent starts */
+BUILD_ASSERT((RSP_SLOT_DELAY * 10 + NUM_SLOTS * RSP_SLOT_SPACING) < SUBEVENT_INTERVAL * 10,
+	     "Too many displays for the PAwR interval");
+BUILD_ASSERT(SUBEVENT_INTERVAL <= UINT8_MAX, "PAwR interval too long");
+
+/* A display is behind once a score change is older than this */
+#define LAG_MS  ((CONFIG_SCOREBOARD_PAWR_APPLY_EVENTS + 2) * CONFIG_SCOREBOARD_PAWR_INTERVAL_MS)
+/* A display that did not answer for this long is lost */
+#define LOST_MS (20 * CONFIG_SCOREBOARD_PAWR_INTERVAL_MS)
+
+static const struct bt_le_adv_param pawr_adv_param = {
+	.id = BT_ID_DEFAULT,
+	.sid = SB_ADV_SID_PAWR,
+	.options = BT_LE_ADV_OPT_EXT_ADV,
+	.interval_min = 320, /* 200ms (320*0.625ms) */
+	.interval_max = 321, /* 200.625ms (321*0.625ms) */
+};
+
+static const struct bt_le_per_adv_param per_adv_param = {
+	.interval_min = PER_INTERVAL,
+	.interval_max = PER_INTERVAL,
+	.options = 0,
+	.num_subevents = SB_PAWR_NUM_SUBEVENTS,
+	.subevent_interval = SUBEVENT_INTERVAL,
+	.response_slot_delay = RSP_SLOT_DELAY,
+	.response_slot_spacing = RSP_SLOT_SPACING,
+	.num_response_slots = NUM_SLOTS,
+};
+
+static const struct bt_data pawr_ad[] = {
+	BT_DATA_BYTES(BT_DATA_FLAGS, BT_LE_AD_NO_BREDR),
+	BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+};
+
+/* Sync status of one display, written by the BT RX thread. The shell reads
+ * it without locking, a status line may mix two updates.
+ */
+struct display {
+	uint32_t ack_ms;
+	uint32_t acks;
+	uint32_t missed;
+	uint16_t seq;
+	uint16_t apply_late_us;
+	int8_t rssi;
+	bool seen;
+};
+
+static struct display displays[NUM_SLOTS];
+
+static struct bt_le_ext_adv *pawr_adv;
+
+/* Score and sequence to send, and when the sequence last changed */
+static struct k_spinlock score_lock;
+static struct sb_pawr_score score;
+static uint32_t seq_ms;
+
+/* Score of the periodic event being filled in, taken at its score
+ * subevent and repeated in its retry subevent. BT RX thread only.
+ */
+static struct sb_pawr_score event_data;
+static uint8_t apply_in;
+
+/* Sequence whose commit jitter was last recorded, and that jitter */
+static uint16_t jitter_seq;
+static uint32_t jitter_us;
+
+static struct bt_le_per_adv_subevent_data_params subevent_params[SB_PAWR_NUM_SUBEVENTS];
+static struct net_buf_simple subevent_bufs[SB_PAWR_NUM_SUBEVENTS];
+static struct sb_pawr_score subevent_data[SB_PAWR_NUM_SUBEVENTS];
+
+static bool display_active(const struct display *d, uint32_t now_ms)
+{
+	return d->seen && ((now_ms - d->ack_ms) < LOST_MS);
+}
+
+static bool display_behind(const struct display *d, uint16_t seq)
+{
+	return (int16_t)(seq - d->seq) > 0;
+}
+
+static bool laggards(uint16_t seq, uint32_t changed_ms, uint32_t now_ms)
+{
+	if ((now_ms - changed_ms) < LAG_MS) {
+		return false;
+	}
+
+	for (uint8_t i = 0; i < NUM_SLOTS; i++) {
+		if (display_active(&displays[i], now_ms) && display_behind(&displays[i], seq)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Once every active display shows the current score, the spread of how late
+ * each started its strip update after its apply time is the commit jitter
+ * of that score change
+ */
+static void jitter_update(uint32_t now_ms)
+{
+	uint16_t seq = sys_le16_to_cpu(event_data.seq);
+	uint16_t min_us = UINT16_MAX;
+	uint16_t max_us = 0;
+	uint8_t shown = 0;
+
+	if (seq == jitter_seq) {
+		return;
+	}
+
+	for (uint8_t i = 0; i < NUM_SLOTS; i++) {
+		const struct display *d = &displays[i];
+
+		if (!display_active(d, now_ms)) {
+			continue;
+		}
+
+		if (d->seq != seq) {
+			return;
+		}
+
+		min_us = MIN(min_us, d->apply_late_us);
+		max_us = MAX(max_us, d->apply_late_us);
+		shown++;
+	}
+
+	if (shown < 2) {
+		return;
+	}
+
+	jitter_seq = seq;
+	jitter_us = max_us - min_us;
+	STATS_HIST(pawr_jitter_us, jitter_us);
+}
+
+static void pawr_data_request(struct bt_le_ext_adv *adv,
+			      const struct bt_le_per_adv_data_request *request)
+{
+	uint32_t now_ms = k_uptime_get_32();
+	struct sb_pawr_score data;
+	uint32_t changed_ms;
+	uint8_t count = 0;
+	bool retry;
+	int err;
+
+	k_spinlock_key_t key = k_spin_lock(&score_lock);
+
+	data = score;
+	changed_ms = seq_ms;
+	k_spin_unlock(&score_lock, key);
+
+	retry = laggards(sys_le16_to_cpu(data.seq), changed_ms, now_ms);
+
+	/* Requests come in subevent order, a score subevent starts the next
+	 * periodic event
+	 */
+	for (uint8_t i = 0; i < MIN(request->count, SB_PAWR_NUM_SUBEVENTS); i++) {
+		uint8_t subevent = (request->start + i) % SB_PAWR_NUM_SUBEVENTS;
+		struct net_buf_simple *buf = &subevent_bufs[count];
+
+		if (subevent == SB_PAWR_SUBEVENT_SCORE) {
+			if (data.seq != event_data.seq) {
+				apply_in = CONFIG_SCOREBOARD_PAWR_APPLY_EVENTS;
+			} else if (apply_in > 0) {
+				apply_in--;
+			}
+
+			event_data = data;
+			event_data.apply_in = apply_in;
+		} else if (!retry) {
+			continue;
+		}
+
+		subevent_data[count] = event_data;
+		net_buf_simple_init_with_data(buf, &subevent_data[count], sizeof(event_data));
+
+		subevent_params[count].subevent = subevent;
+		subevent_params[count].response_slot_start = 0;
+		subevent_params[count].response_slot_count = NUM_SLOTS;
+		subevent_params[count].data = buf;
+		count++;
+
+		if (subevent == SB_PAWR_SUBEVENT_RETRY) {
+			STATS_INC(pawr_retries);
+		}
+	}
+
+	if (count == 0) {
+		return;
+	}
+
+	err = bt_le_per_adv_set_subevent_data(adv, count, subevent_params);
+	if (err) {
+		LOG_ERR("Failed to set subevent data (err %d)", err);
+	}
+}
+
+static void pawr_response(struct bt_le_ext_adv *adv, struct bt_le_per_adv_response_info *info,
+			  struct net_buf_simple *buf)
+{
+	const struct sb_pawr_ack *ack;
+	struct display *d;
+
+	if (info->response_slot >= NUM_SLOTS) {
+		return;
+	}
+
+	d = &displays[info->response_slot];
+
+	if (!buf) {
+		/* Only count the slots of displays that answered before */
+		if (d->seen) {
+			d->missed++;
+			STATS_INC(pawr_missed);
+		}
+		return;
+	}
+
+	if (buf->len < sizeof(*ack)) {
+		return;
+	}
+
+	ack = (const struct sb_pawr_ack *)buf->data;
+	if ((sys_le16_to_cpu(ack->company_id) != COMPANY_ID_CODE) ||
+	    (ack->display_id != info->response_slot)) {
+		return;
+	}
+
+	d->seq = sys_le16_to_cpu(ack->seq);
+	d->apply_late_us = sys_le16_to_cpu(ack->apply_late_us);
+	d->ack_ms = k_uptime_get_32();
+	d->rssi = info->rssi;
+	d->acks++;
+	d->seen = true;
+	STATS_INC(pawr_acks);
+
+	jitter_update(d->ack_ms);
+}
+
+static const struct bt_le_ext_adv_cb pawr_adv_cb = {
+	.pawr_data_request = pawr_data_request,
+	.pawr_response = pawr_response,
+};
+
+/* Send a new score in the next periodic events, with the next sequence */
+static void pawr_score_update(const void *data, size_t len)
+{
+	k_spinlock_key_t key = k_spin_lock(&score_lock);
+
+	memcpy(&score.score, data, MIN(len, sizeof(score.score)));
+	score.seq = sys_cpu_to_le16(sys_le16_to_cpu(score.seq) + 1);
+	seq_ms = k_uptime_get_32();
+	k_spin_unlock(&score_lock, key);
+}
+
+static void adv_payload_cb(const struct zbus_channel *chan)
+{
+	pawr_score_update(zbus_chan_const_msg(chan), sizeof(struct sb_score));
+}
+
+ZBUS_LISTENER_DEFINE(pawr_score_lis, adv_payload_cb);
+
+int pawr_init(const void *data, size_t len)
+{
+	int err;
+
+	memcpy(&score.score, data, MIN(len, sizeof(score.score)));
+
+	err = zbus_chan_add_obs(&adv_payload_chan, &pawr_score_lis, K_FOREVER);
+	if (err) {
+		return err;
+	}
+
+	err = bt_le_ext_adv_create(&pawr_adv_param, &pawr_adv_cb, &pawr_adv);
+	if (err) {
+		return err;
+	}
+
+	err = bt_le_ext_adv_set_data(pawr_adv, pawr_ad, ARRAY_SIZE(pawr_ad), NULL, 0);
+	if (err) {
+		return err;
+	}
+
+	err = bt_le_per_adv_set_param(pawr_adv, &per_adv_param);
+	if (err) {
+		return err;
+	}
+
+	err = bt_le_per_adv_start(pawr_adv);
+	if (err) {
+		return err;
+	}
+
+	return bt_le_ext_adv_start(pawr_adv, BT_LE_EXT_ADV_START_DEFAULT);
+}
+
+void pawr_displays_print(const struct shell *sh)
+{
+	uint32_t now_ms = k_uptime_get_32();
+	uint16_t seq;
+
+	k_spinlock_key_t key = k_spin_lock(&score_lock);
+
+	seq = sys_le16_to_cpu(score.seq);
+	k_spin_unlock(&score_lock, key);
+
+	shell_print(sh, "score seq %u, commit jitter %u us at seq %u", seq, jitter_us,
+		    jitter_seq);
+	shell_print(sh, "%-4s %-7s %6s %6s %9s %8s %5s %8s %8s", "id", "status", "seq", "behind",
+		    "ack ago", "late", "rssi", "acks", "missed");
+
+	for (uint8_t i = 0; i < NUM_SLOTS; i++) {
+		const struct display *d = &displays[i];
+		const char *status;
+
+		if (!d->seen) {
+			continue;
+		}
+
+		if (!display_active(d, now_ms)) {
+			status = "lost";
+		} else if (display_behind(d, seq)) {
+			status = "behind";
+		} else {
+			status = "synced";
+		}
+
+		shell_print(sh, "%-4u %-7s %6u %6u %6u ms %5u us %5d %8u %8u", i, status, d->seq,
+			    display_behind(d, seq) ? (uint16_t)(seq - d->seq) : 0,
+			    now_ms - d->ack_ms, d->apply_late_us, d->rssi, d->acks, d->missed);
+	}
+}
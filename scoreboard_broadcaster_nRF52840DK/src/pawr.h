@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef PAWR_H_
+#define PAWR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/shell/shell.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Start the periodic advertising with responses set and send every
+ * score published on adv_payload_chan, with a sequence counted up.
+ *
+ * @param score Initial score, struct sb_score.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int pawr_init(const void *score, size_t len);
+
+/** @brief Print the sync status of every display that answered. */
+void pawr_displays_print(const struct shell *sh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAWR_H_ */
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Score replicas shared between broadcasters.
+ *
+ * Every broadcaster advertises all the replicas it knows on its own set
+ * (SB_ADV_SID_CRDT) and scans for the sets of its peers. A replica heard is
+ * merged into the local state, see crdt.c. The merge takes the maximum of
+ * each counter, so reports heard twice, late or out of order change
+ * nothing, and a broadcaster passes on the replicas of peers out of range
+ * of each other.
+ *
+ * The BT RX thread only collects the replicas heard, merged by the same
+ * maximum so that none is lost while thread0 is busy. thread0 takes them
+ * and merges them into the score between two commands.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/net/buf.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+#include <scoreboard_proto.h>
+#include "crdt.h"
+#include "peer.h"
+#include "phy.h"
+#include "stats.h"
+
+LOG_MODULE_DECLARE(Scoreboard, LOG_LEVEL_INF);
+
+#define COMPANY_ID_CODE 0x0059 // Nordic BLE ID
+
+#define CRDT_DATA_MAX_LEN \
+	(SB_CRDT_HEADER_LEN + CONFIG_SCOREBOARD_CRDT_REPLICAS * sizeof(struct sb_crdt_replica))
+
+BUILD_ASSERT(CRDT_DATA_MAX_LEN <= 251, "Replicas do not fit one advertising data element");
+
+static const struct bt_le_adv_param crdt_adv_param = {
+	.id = BT_ID_DEFAULT,
+	.sid = SB_ADV_SID_CRDT,
+	.options = BT_LE_ADV_OPT_EXT_ADV | PHY_ADV_OPTIONS,
+	.interval_min = 320, /* 200ms (320*0.625ms) */
+	.interval_max = 321, /* 200.625ms (321*0.625ms) */
+};
+
+static struct bt_le_ext_adv *crdt_adv;
+static uint8_t crdt_data[CRDT_DATA_MAX_LEN];
+static uint8_t crdt_data_sent[CRDT_DATA_MAX_LEN];
+static size_t crdt_data_sent_len;
+
+static struct bt_data crdt_ad[] = {
+	BT_DATA_BYTES(BT_DATA_FLAGS, BT_LE_AD_NO_BREDR),
+	BT_DATA(BT_DATA_NAME_COMPLETE, CONFIG_BT_DEVICE_NAME, sizeof(CONFIG_BT_DEVICE_NAME) - 1),
+	BT_DATA(BT_DATA_MANUFACTURER_DATA, crdt_data, 0),
+};
+
+/* Replicas heard since thread0 last took them, written by the BT RX thread */
+static struct sb_crdt_replica heard[CONFIG_SCOREBOARD_CRDT_REPLICAS];
+static uint8_t heard_count;
+static uint8_t heard_epoch; /* Highest ever heard */
+static struct k_spinlock heard_lock;
+
+static peer_heard_cb_t heard_cb;
+
+/* Keep the newest state of a replica until thread0 takes it */
+static bool heard_add(const struct sb_crdt_replica *remote)
+{
+	k_spinlock_key_t key = k_spin_lock(&heard_lock);
+	struct sb_crdt_replica *r = NULL;
+	bool grew;
+
+	for (uint8_t i = 0; i < heard_count; i++) {
+		if (heard[i].id == remote->id) {
+			r = &heard[i];
+			break;
+		}
+	}
+
+	if ((r == NULL) && (heard_count < ARRAY_SIZE(heard))) {
+		r = &heard[heard_count++];
+		memset(r, 0, sizeof(*r));
+		r->id = remote->id;
+	}
+
+	grew = (r != NULL) && crdt_replica_max(r, remote);
+	k_spin_unlock(&heard_lock, key);
+
+	return grew;
+}
+
+/* Keep the highest epoch heard, thread0 merges it with the replicas */
+static bool heard_epoch_add(uint8_t epoch)
+{
+	k_spinlock_key_t key = k_spin_lock(&heard_lock);
+	bool grew = epoch > heard_epoch;
+
+	heard_epoch = MAX(heard_epoch, epoch);
+	k_spin_unlock(&heard_lock, key);
+
+	return grew;
+}
+
+static bool data_cb(struct bt_data *data, void *user_data)
+{
+	const struct sb_crdt_replica *remote;
+	bool grew;
+	size_t n;
+
+	if (data->type != BT_DATA_MANUFACTURER_DATA) {
+		return true;
+	}
+
+	if ((data->data_len < SB_CRDT_HEADER_LEN) || (sys_get_le16(data->data) != COMPANY_ID_CODE) ||
+	    (data->data[2] != SB_CRDT_RECORD_ID)) {
+		return false;
+	}
+
+	grew = heard_epoch_add(data->data[3]);
+
+	n = (data->data_len - SB_CRDT_HEADER_LEN) / sizeof(struct sb_crdt_replica);
+	remote = (const struct sb_crdt_replica *)&data->data[SB_CRDT_HEADER_LEN];
+
+	for (size_t i = 0; i < n; i++) {
+		grew |= heard_add(&remote[i]);
+	}
+
+	if (grew) {
+		heard_cb();
+	}
+
+	return false;
+}
+
+static void scan_recv(const struct bt_le_scan_recv_info *info, struct net_buf_simple *buf)
+{
+	if (info->sid != SB_ADV_SID_CRDT) {
+		return;
+	}
+
+	STATS_INC(crdt_reports);
+	bt_data_parse(buf, data_cb, NULL);
+}
+
+static struct bt_le_scan_cb scan_callbacks = {
+	.recv = scan_recv,
+};
+
+int peer_init(peer_heard_cb_t heard)
+{
+	struct bt_le_scan_param scan_param = {
+		.type = BT_LE_SCAN_TYPE_PASSIVE,
+		.options = BT_LE_SCAN_OPT_FILTER_DUPLICATE,
+		.interval = BT_GAP_SCAN_FAST_INTERVAL,
+		.window = BT_GAP_SCAN_FAST_WINDOW,
+	};
+	int err;
+
+	heard_cb = heard;
+
+	err = bt_le_ext_adv_create(&crdt_adv_param, NULL, &crdt_adv);
+	if (err) {
+		return err;
+	}
+
+	peer_update();
+
+	err = bt_le_ext_adv_start(crdt_adv, BT_LE_EXT_ADV_START_DEFAULT);
+	if (err) {
+		return err;
+	}
+
+	bt_le_scan_cb_register(&scan_callbacks);
+
+	return bt_le_scan_start(&scan_param, NULL);
+}
+
+size_t peer_take(struct sb_crdt_replica *replicas, size_t count, uint8_t *epoch)
+{
+	k_spinlock_key_t key = k_spin_lock(&heard_lock);
+	size_t n = MIN(count, heard_count);
+
+	memcpy(replicas, heard, n * sizeof(heard[0]));
+	heard_count = 0;
+	*epoch = heard_epoch;
+	k_spin_unlock(&heard_lock, key);
+
+	return n;
+}
+
+void peer_update(void)
+{
+	size_t len = crdt_encode(crdt_data, sizeof(crdt_data));
+	int err;
+
+	/* Unchanged data would only make the controller pick a new DID */
+	if ((len == crdt_data_sent_len) && (memcmp(crdt_data_sent, crdt_data, len) == 0)) {
+		return;
+	}
+
+	crdt_ad[2].data_len = len;
+
+	err = bt_le_ext_adv_set_data(crdt_adv, crdt_ad, ARRAY_SIZE(crdt_ad), NULL, 0);
+	if (err) {
+		LOG_ERR("Failed to update replicas (err %d)", err);
+		return;
+	}
+
+	memcpy(crdt_data_sent, crdt_data, len);
+	crdt_data_sent_len = len;
+	STATS_INC(crdt_adv_updates);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef PEER_H_
+#define PEER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <scoreboard_proto.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Called from the BT RX thread when replicas newer than those
+ * heard before are waiting for peer_take().
+ */
+typedef void (*peer_heard_cb_t)(void);
+
+/**
+ * @brief Start advertising the replicas and scanning for peer broadcasters.
+ *
+ * @param heard Callback for newly heard replicas.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int peer_init(peer_heard_cb_t heard);
+
+/**
+ * @brief Take the replicas heard since the last call, for crdt_merge().
+ * Called from thread0.
+ *
+ * @param replicas Output array.
+ * @param count Size of @p replicas, CONFIG_SCOREBOARD_CRDT_REPLICAS holds all.
+ * @param epoch Highest epoch heard, for crdt_merge_epoch().
+ *
+ * @return Number of replicas written.
+ */
+size_t peer_take(struct sb_crdt_replica *replicas, size_t count, uint8_t *epoch);
+
+/** @brief Advertise the replicas again if they changed. Called from thread0. */
+void peer_update(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PEER_H_ */
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Air time of the advertising PDUs on the configured PHY, from the packet
+ * formats of the Core specification, Vol 6, Part B, 2.1 and 2.2. LE Coded
+ * is counted with S8 coding, which is what the controller uses by default.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gap.h>
+#include "phy.h"
+
+/* PDU header, access address and CRC around the payload */
+#define PDU_HEADER_LEN   2
+#define PDU_AA_LEN       4
+#define PDU_CRC_LEN      3
+
+/* Extended header: length and mode, flags, AdvA, ADI, AuxPtr */
+#define EXT_HDR_LEN_MODE 1
+#define EXT_HDR_FLAGS    1
+#define EXT_HDR_ADV_A    6
+#define EXT_HDR_ADI      2
+#define EXT_HDR_AUX_PTR  3
+
+#define PDU_PAYLOAD_MAX  255
+
+/* LE Coded S8: 80 us preamble, access address, CI and TERM1 at 8 us per
+ * bit, then header, payload, CRC and TERM2 at 8 us per bit
+ */
+#define CODED_PREAMBLE_US 80
+#define CODED_FEC1_US     ((PDU_AA_LEN * 8 + 2 + 3) * 8)
+#define CODED_S           8
+
+#if defined(CONFIG_SCOREBOARD_PHY_CODED)
+#define PRIMARY_PHY   BT_GAP_LE_PHY_CODED
+#define SECONDARY_PHY BT_GAP_LE_PHY_CODED
+#elif defined(CONFIG_SCOREBOARD_PHY_1M)
+#define PRIMARY_PHY   BT_GAP_LE_PHY_1M
+#define SECONDARY_PHY BT_GAP_LE_PHY_1M
+#else
+#define PRIMARY_PHY   BT_GAP_LE_PHY_1M
+#define SECONDARY_PHY BT_GAP_LE_PHY_2M
+#endif
+
+static uint32_t pdu_airtime_us(uint8_t phy, size_t payload_len)
+{
+	switch (phy) {
+	case BT_GAP_LE_PHY_CODED:
+		return CODED_PREAMBLE_US + CODED_FEC1_US +
+		       ((PDU_HEADER_LEN + payload_len + PDU_CRC_LEN) * 8 + 3) * CODED_S;
+	case BT_GAP_LE_PHY_2M:
+		/* 2 byte preamble, 4 us per byte */
+		return (2 + PDU_AA_LEN + PDU_HEADER_LEN + payload_len + PDU_CRC_LEN) * 4;
+	default:
+		/* 1 byte preamble, 8 us per byte */
+		return (1 + PDU_AA_LEN + PDU_HEADER_LEN + payload_len + PDU_CRC_LEN) * 8;
+	}
+}
+
+const char *phy_name(void)
+{
+	if (IS_ENABLED(CONFIG_SCOREBOARD_PHY_CODED)) {
+		return "Coded";
+	}
+
+	return IS_ENABLED(CONFIG_SCOREBOARD_PHY_1M) ? "1M" : "2M";
+}
+
+uint32_t phy_adv_event_airtime_us(const struct bt_data *ad, size_t count)
+{
+	const size_t ext_hdr = EXT_HDR_LEN_MODE + EXT_HDR_FLAGS + EXT_HDR_ADI;
+	size_t adv_a = EXT_HDR_ADV_A;
+	size_t ad_len = 0;
+	uint32_t airtime_us;
+
+	for (size_t i = 0; i < count; i++) {
+		ad_len += 2 + ad[i].data_len;
+	}
+
+	/* ADV_EXT_IND on each primary channel, pointing to the aux PDU */
+	airtime_us = 3 * pdu_airtime_us(PRIMARY_PHY, ext_hdr + EXT_HDR_AUX_PTR);
+
+	/* AUX_ADV_IND with the advertiser address, and as many AUX_CHAIN_IND
+	 * without it as the data needs, all but the last one with an AuxPtr
+	 */
+	do {
+		size_t room = PDU_PAYLOAD_MAX - ext_hdr - adv_a;
+		size_t chunk;
+
+		if (ad_len > room) {
+			room -= EXT_HDR_AUX_PTR;
+		}
+		chunk = MIN(ad_len, room);
+
+		airtime_us += pdu_airtime_us(SECONDARY_PHY, PDU_PAYLOAD_MAX - room + chunk);
+		ad_len -= chunk;
+		adv_a = 0;
+	} while (ad_len > 0);
+
+	return airtime_us;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef PHY_H_
+#define PHY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Advertising options of the PHY chosen with CONFIG_SCOREBOARD_PHY_*. The
+ * primary channels are 1M or Coded, 2M only exists on the secondary ones.
+ */
+#if defined(CONFIG_SCOREBOARD_PHY_CODED)
+#define PHY_ADV_OPTIONS BT_LE_ADV_OPT_CODED
+#elif defined(CONFIG_SCOREBOARD_PHY_1M)
+#define PHY_ADV_OPTIONS BT_LE_ADV_OPT_NO_2M
+#else
+#define PHY_ADV_OPTIONS 0
+#endif
+
+/** @brief Name of the configured PHY, for logging. */
+const char *phy_name(void);
+
+/**
+ * @brief Air time of one extended advertising event on the configured PHY.
+ *
+ * Counts the ADV_EXT_IND on the three primary channels and the AUX_ADV_IND
+ * and AUX_CHAIN_IND PDUs carrying the data, without inter frame spaces.
+ *
+ * @param ad Advertising data.
+ * @param count Number of elements in @p ad.
+ *
+ * @return Air time in microseconds.
+ */
+uint32_t phy_adv_event_airtime_us(const struct bt_data *ad, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PHY_H_ */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+#include <scoreboard_proto.h>
+#include "df2301q.h"
+#include "score.h"
+
+/* Add one point to, or take one from, a little endian score, within
+ * 0 and CONFIG_SCOREBOARD_POINTS_MAX
+ */
+static uint16_t points_step(uint16_t points_le, int delta)
+{
+	uint16_t points = sys_le16_to_cpu(points_le);
+
+	if ((delta > 0) && (points < CONFIG_SCOREBOARD_POINTS_MAX)) {
+		points++;
+	} else if ((delta < 0) && (points > 0)) {
+		points--;
+	}
+
+	return sys_cpu_to_le16(points);
+}
+
+static uint8_t sets_step(uint8_t sets, int delta)
+{
+	if ((delta > 0) && (sets < SCORE_SETS_MAX)) {
+		return sets + 1;
+	}
+
+	if ((delta < 0) && (sets > 0)) {
+		return sets - 1;
+	}
+
+	return sets;
+}
+
+bool score_apply_cmd(struct sb_score *score, uint8_t cmd)
+{
+	struct sb_score before = *score;
+
+	switch (cmd) {
+	case TEAM_HOME_PLUS_ONE_POINT:
+		score->home_points = points_step(score->home_points, 1);
+		break;
+	case TEAM_HOME_MINUS_ONE_POINT:
+		score->home_points = points_step(score->home_points, -1);
+		break;
+	case TEAM_GUEST_PLUS_ONE_POINT:
+		score->guest_points = points_step(score->guest_points, 1);
+		break;
+	case TEAM_GUEST_MINUS_ONE_POINT:
+		score->guest_points = points_step(score->guest_points, -1);
+		break;
+	case TEAM_HOME_PLUS_ONE_SET:
+		score->home_sets = sets_step(score->home_sets, 1);
+		break;
+	case TEAM_HOME_MINUS_ONE_SET:
+		score->home_sets = sets_step(score->home_sets, -1);
+		break;
+	case TEAM_GUEST_PLUS_ONE_SET:
+		score->guest_sets = sets_step(score->guest_sets, 1);
+		break;
+	case TEAM_GUEST_MINUS_ONE_SET:
+		score->guest_sets = sets_step(score->guest_sets, -1);
+		break;
+	case TEAM_HOME_SERVING:
+		score->serving |= 1 << TEAM_HOME_SERVING_BIT;
+		score->serving &= ~(1 << TEAM_GUEST_SERVING_BIT);
+		break;
+	case TEAM_GUEST_SERVING:
+		score->serving |= 1 << TEAM_GUEST_SERVING_BIT;
+		score->serving &= ~(1 << TEAM_HOME_SERVING_BIT);
+		break;
+	case SCORE_BOARD_RESET:
+		score->home_points = 0;
+		score->guest_points = 0;
+		score->home_sets = 0;
+		score->guest_sets = 0;
+		score->serving = 0;
+		break;
+	default:
+		return false;
+	}
+
+	return memcmp(&before, score, sizeof(before)) != 0;
+}
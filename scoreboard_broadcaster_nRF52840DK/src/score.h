@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef SCORE_H_
+#define SCORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <scoreboard_proto.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sets stop counting up here */
+#define SCORE_SETS_MAX 9
+
+/**
+ * @brief Apply a DF2301Q command word to a score.
+ *
+ * Only depends on @p score and @p cmd, so that the journal replays to the
+ * same score.
+ *
+ * @param score Score, little endian as on air.
+ * @param cmd Command word ID, others than the score commands are ignored.
+ *
+ * @return true if the score changed.
+ */
+bool score_apply_cmd(struct sb_score *score, uint8_t cmd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCORE_H_ */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Log of the voice commands and scores, from a zbus subscriber.
+ *
+ * The subscriber thread runs below thread0, so logging never delays an
+ * update. A subscriber is only told which channel was published and reads
+ * it when it gets to run, so of a fast burst it logs the newest message.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/zbus/zbus.h>
+#include <scoreboard_proto.h>
+#include "channels.h"
+
+LOG_MODULE_DECLARE(Scoreboard, LOG_LEVEL_INF);
+
+#define SCORE_LOG_STACKSIZE 1024
+#define SCORE_LOG_PRIORITY  7
+
+ZBUS_SUBSCRIBER_DEFINE(score_log_sub, 8);
+
+static void score_log_thread(void)
+{
+	const struct zbus_channel *chan;
+	struct voice_cmd cmd;
+	struct sb_score score;
+
+	if ((zbus_chan_add_obs(&voice_cmd_chan, &score_log_sub, K_FOREVER) != 0) ||
+	    (zbus_chan_add_obs(&score_chan, &score_log_sub, K_FOREVER) != 0)) {
+		LOG_ERR("Score log not attached");
+		return;
+	}
+
+	while (zbus_sub_wait(&score_log_sub, &chan, K_FOREVER) == 0) {
+		if ((chan == &voice_cmd_chan) && (zbus_chan_read(chan, &cmd, K_FOREVER) == 0)) {
+			LOG_INF("Command 0x%02x from voice input %u, msgSeq %u", cmd.cmd,
+				cmd.source, cmd.seq);
+		} else if ((chan == &score_chan) && (zbus_chan_read(chan, &score, K_FOREVER) == 0)) {
+			LOG_INF("Score %u-%u, sets %u-%u, serving 0x%x",
+				sys_le16_to_cpu(score.home_points), sys_le16_to_cpu(score.guest_points),
+				score.home_sets, score.guest_sets, score.serving);
+		}
+	}
+}
+
+K_THREAD_DEFINE(score_log_id, SCORE_LOG_STACKSIZE, score_log_thread, NULL, NULL, NULL,
+		SCORE_LOG_PRIORITY, 0, 0);
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <string.h>
+#include "journal.h"
+#include "pawr.h"
+#include "stats.h"
+
+SB_STATS_SHELL_DEFINE(sb);
+
+#if defined(CONFIG_SCOREBOARD_PAWR)
+static int cmd_displays(const struct shell *sh, size_t argc, char **argv)
+{
+	pawr_displays_print(sh);
+
+	return 0;
+}
+#endif
+
+static int cmd_journal(const struct shell *sh, size_t argc, char **argv)
+{
+	int err;
+
+	if ((argc > 1) && (strcmp(argv[1], "clear") == 0)) {
+		err = journal_clear();
+		if (err) {
+			shell_error(sh, "clear failed (err %d)", err);
+		}
+		return err;
+	}
+
+	journal_print(sh);
+
+	return 0;
+}
+
+static int cmd_replay(const struct shell *sh, size_t argc, char **argv)
+{
+	return journal_replay(sh, (argc > 1) && (strcmp(argv[1], "flash") == 0));
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sb_cmds,
+	SB_STATS_SHELL_CMDS(sb),
+	SHELL_CMD_ARG(journal, NULL, "Newest journal entries, \"clear\" to start over",
+		      cmd_journal, 1, 1),
+	SHELL_CMD_ARG(replay, NULL, "Replay the journal, or the flash log with \"flash\"",
+		      cmd_replay, 1, 1),
+	IF_ENABLED(CONFIG_SCOREBOARD_PAWR,
+		   (SHELL_CMD(displays, NULL, "PAwR sync status of the displays", cmd_displays),))
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(sb, &sb_cmds, "Scoreboard broadcaster statistics", NULL);
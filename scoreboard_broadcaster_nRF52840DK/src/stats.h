@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <sb_stats.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Counters, with their single writer */
+#define STATS_COUNTERS(X)                                                      \
+	X(uart_frames_rx)       /* UART ISR: frames received */                 \
+	X(uart_frames_rejected) /* UART ISR: frames with an unknown length */   \
+	X(uart_frames_dropped)  /* UART ISR: frames with the queue full */      \
+	X(cmd_bad_header)       /* thread0: frames without the F4 F5 header */  \
+	X(cmds_dispatched)      /* thread0: command frames processed */         \
+	X(cmd_dup_frames)       /* thread0: same command and msgSeq dropped */  \
+	X(cmd_dup_repeats)      /* thread0: repeated commands dropped */        \
+	X(adv_score_updates)    /* thread0: score set data updates */           \
+	X(adv_match_updates)    /* match_lock holder: match set data updates */ \
+	X(gatt_notifies)        /* thread0: score notifications sent */         \
+	X(gatt_notify_errors)   /* thread0: score notifications not sent */      \
+	X(pawr_acks)            /* BT RX: display responses */                  \
+	X(pawr_missed)          /* BT RX: empty slots of known displays */      \
+	X(pawr_retries)         /* BT RX: retry subevents for lagging displays */ \
+	X(journal_entries)      /* thread0: commands and undos journaled */     \
+	X(journal_undos)        /* thread0: commands taken back */              \
+	X(journal_flushed)      /* Workqueue: entries written to flash */       \
+	X(journal_overruns)     /* Workqueue: entries overwritten unwritten */  \
+	X(journal_flash_errors) /* Workqueue: failed flash writes */          \
+	X(crdt_reports)         /* BT RX: replica reports of peers */           \
+	X(crdt_merges)          /* thread0: peer replicas that were merged */   \
+	X(crdt_own_adopted)     /* thread0: own replicas taken from peers */    \
+	X(crdt_own_rejects)     /* thread0: own replicas a peer holds ahead */  \
+	X(crdt_dropped)         /* thread0: peer replicas without room */       \
+	X(crdt_adv_updates)     /* thread0: replica set data updates */
+
+/* Histograms in microseconds */
+#define STATS_HISTS(X)                                                         \
+	X(cmd_dispatch_us)      /* thread0 */                                   \
+	X(gatt_notify_us)       /* thread0: fanout of one score notification */ \
+	X(adv_airtime_us)       /* thread0: air time of one score set event */  \
+	X(match_airtime_us)     /* match_lock holder: one match set event */    \
+	X(pawr_jitter_us)       /* BT RX: displays' commit jitter */            \
+	X(journal_flush_us)     /* Workqueue: one entry appended to flash */    \
+	X(voice_cmd_pub_us)     /* thread0: voice_cmd_chan, with the dispatch */ \
+	X(score_pub_us)         /* thread0: score_chan, with the payload */     \
+	X(adv_payload_pub_us)   /* thread0: adv_payload_chan, radio updates */
+
+struct stats {
+	STATS_COUNTERS(SB_STATS_FIELD)
+};
+
+struct stats_hists {
+	STATS_HISTS(SB_STATS_HIST_FIELD)
+};
+
+extern struct stats stats;
+extern struct stats_hists stats_hists;
+
+#define STATS_INC(_counter) sb_stat_inc(&stats._counter)
+#define STATS_HIST(_hist, _val) sb_hist_add(&stats_hists._hist, (_val))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATS_H_ */
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef SCOREBOARD_LAYOUT_BINDINGS_H_
+#define SCOREBOARD_LAYOUT_BINDINGS_H_
+
+/* Seven segment names for segment-map, also the bit of each segment in the
+ * glyph tables
+ *
+ *    aaa
+ *   f   b
+ *    ggg
+ *   e   c
+ *    ddd
+ */
+#define SEG_A 0
+#define SEG_B 1
+#define SEG_C 2
+#define SEG_D 3
+#define SEG_E 4
+#define SEG_F 5
+#define SEG_G 6
+
+#endif /* SCOREBOARD_LAYOUT_BINDINGS_H_ */
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2024 Markel Robregado
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Decode the observer's dictionary (binary) log output on the host.
+
+The firmware only sends packaged log arguments. The format strings live in
+the log database generated with the build, build/zephyr/log_dictionary.json.
+This script feeds a serial port or a captured file to the dictionary log
+parser shipped with Zephyr.
+
+    scripts/log_decode.py --serial /dev/ttyACM0
+    scripts/log_decode.py --file capture.bin
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+
+
+def zephyr_script(name):
+    zephyr_base = os.environ.get("ZEPHYR_BASE")
+    if not zephyr_base:
+        sys.exit("ZEPHYR_BASE is not set")
+
+    return os.path.join(zephyr_base, "scripts", "logging", "dictionary", name)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--build-dir", default="build",
+                        help="Build directory of the observer (default: build)")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--serial", help="Serial port to read the log from")
+    source.add_argument("--file", help="Captured binary log to decode")
+    parser.add_argument("--baudrate", type=int, default=115200,
+                        help="Serial baud rate (default: 115200)")
+    args = parser.parse_args()
+
+    database = os.path.join(args.build_dir, "zephyr", "log_dictionary.json")
+    if not os.path.isfile(database):
+        sys.exit(f"{database} not found, build with dictionary logging first")
+
+    if args.serial:
+        cmd = [sys.executable, zephyr_script("log_parser_uart.py"),
+               database, args.serial, str(args.baudrate)]
+    else:
+        cmd = [sys.executable, zephyr_script("log_parser.py"),
+               database, args.file]
+
+    return subprocess.call(cmd)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Digit transitions.
+ *
+ * Only the pixels that differ between the old and the new glyph take part.
+ * For the flash and the crossfade they are moved to the team's "in" and
+ * "out" palette entries when the transition starts, after which every frame
+ * only recomputes those two colors. The segment wipe switches the differing
+ * pixels over in chain order, which goes around the digit segment by
+ * segment.
+ *
+ * Progress is Q16 fixed point and eased with smoothstep, there is no
+ * floating point. The old glyph is read back from the framebuffer, so the
+ * widgets keep no shadow copy. A frame only computes one or two palette
+ * colors, so this is plain per channel math, not the pixel kernels.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include "anim.h"
+#include "framebuffer.h"
+
+#define Q16_ONE     BIT(16)
+
+/* Full weight of scaled() */
+#define WEIGHT_ONE  256
+
+#define ANIM_FRAMES MAX(CONFIG_SCOREBOARD_ANIM_MS * CONFIG_SCOREBOARD_FPS / 1000, 1)
+
+/* Blinks of the flash transition */
+#define ANIM_FLASHES 3
+
+static const struct led_rgb black;
+
+/* 3p^2 - 2p^3 */
+static uint32_t ease(uint32_t p)
+{
+	uint32_t p2 = (p * p) >> 16;
+
+	return ((uint64_t)p2 * (3 * Q16_ONE - 2 * p)) >> 16;
+}
+
+/* @p color times @p weight / WEIGHT_ONE */
+static struct led_rgb scaled(struct led_rgb color, uint16_t weight)
+{
+	color.r = (color.r * weight) >> 8;
+	color.g = (color.g * weight) >> 8;
+	color.b = (color.b * weight) >> 8;
+
+	return color;
+}
+
+static void anim_finish(struct anim *anim)
+{
+	for(uint8_t j = 0; j < anim->num_digits; j++)
+	{
+		const struct anim_digit *d = &anim->digits[j];
+
+		for(uint8_t i = 0; i < d->len; i++)
+		{
+			if((d->from ^ d->to) & BIT(i))
+			{
+				fb_set(d->index + i, (d->to & BIT(i)) ? anim->color : FB_INDEX_OFF);
+			}
+		}
+	}
+
+	anim->num_digits = 0;
+	anim->frame = 0;
+	anim->active = false;
+}
+
+static void anim_start(struct anim *anim)
+{
+	struct led_rgb color = fb_palette_get(anim->color);
+
+	if(IS_ENABLED(CONFIG_SCOREBOARD_ANIM_FLASH))
+	{
+		fb_palette_set(anim->in, color);
+		fb_palette_set(anim->out, black);
+	}
+	else if(IS_ENABLED(CONFIG_SCOREBOARD_ANIM_CROSSFADE))
+	{
+		fb_palette_set(anim->in, black);
+		fb_palette_set(anim->out, color);
+	}
+
+	anim->active = true;
+}
+
+void anim_digit(struct anim *anim, uint16_t index, uint8_t len, uint32_t glyph)
+{
+	struct anim_digit *d;
+	uint32_t from = 0;
+
+	__ASSERT_NO_MSG(len <= 32);
+
+	/* A digit in transition is on its way to the glyph already, otherwise
+	 * the framebuffer holds the shown glyph
+	 */
+	for(uint8_t j = 0; j < anim->num_digits; j++)
+	{
+		if(anim->digits[j].index == index)
+		{
+			if(anim->digits[j].to == glyph)
+			{
+				return;
+			}
+			anim_finish(anim);
+			break;
+		}
+	}
+
+	for(uint8_t i = 0; i < len; i++)
+	{
+		if(fb_get(index + i) != FB_INDEX_OFF)
+		{
+			from |= BIT(i);
+		}
+	}
+
+	if(from == glyph)
+	{
+		return;
+	}
+
+	/* A change after the first frame preempts the running transition */
+	if(anim->active && (anim->frame > 0))
+	{
+		anim_finish(anim);
+	}
+
+	if(IS_ENABLED(CONFIG_SCOREBOARD_ANIM_NONE) || (anim->num_digits == ANIM_MAX_DIGITS))
+	{
+		for(uint8_t i = 0; i < len; i++)
+		{
+			fb_set(index + i, (glyph & BIT(i)) ? anim->color : FB_INDEX_OFF);
+		}
+		return;
+	}
+
+	if(!anim->active)
+	{
+		anim_start(anim);
+	}
+
+	d = &anim->digits[anim->num_digits++];
+	d->index = index;
+	d->len = len;
+	d->from = from;
+	d->to = glyph;
+
+	if(IS_ENABLED(CONFIG_SCOREBOARD_ANIM_WIPE))
+	{
+		return;
+	}
+
+	for(uint8_t i = 0; i < len; i++)
+	{
+		if((from ^ glyph) & BIT(i))
+		{
+			fb_set(index + i, (glyph & BIT(i)) ? anim->in : anim->out);
+		}
+	}
+}
+
+bool anim_step(struct anim *anim)
+{
+	struct led_rgb color;
+	uint32_t p;
+
+	if(!anim->active)
+	{
+		return false;
+	}
+
+	if(++anim->frame >= ANIM_FRAMES)
+	{
+		anim_finish(anim);
+		return true;
+	}
+
+	color = fb_palette_get(anim->color);
+	p = anim->frame * Q16_ONE / ANIM_FRAMES;
+
+	if(IS_ENABLED(CONFIG_SCOREBOARD_ANIM_FLASH))
+	{
+		/* Triangle from full to off and back, ANIM_FLASHES times */
+		uint32_t phase = (p * ANIM_FLASHES) & (Q16_ONE - 1);
+		uint32_t level = (phase < Q16_ONE / 2) ? Q16_ONE - 2 * phase :
+							 2 * phase - Q16_ONE;
+
+		fb_palette_set(anim->in, scaled(color, level >> 8));
+	}
+	else if(IS_ENABLED(CONFIG_SCOREBOARD_ANIM_CROSSFADE))
+	{
+		uint16_t t = ease(p) >> 8;
+
+		fb_palette_set(anim->in, scaled(color, t));
+		fb_palette_set(anim->out, scaled(color, WEIGHT_ONE - t));
+	}
+	else if(IS_ENABLED(CONFIG_SCOREBOARD_ANIM_WIPE))
+	{
+		uint32_t eased = ease(p);
+
+		for(uint8_t j = 0; j < anim->num_digits; j++)
+		{
+			const struct anim_digit *d = &anim->digits[j];
+			uint8_t cut = (eased * d->len) >> 16;
+
+			for(uint8_t i = 0; i < cut; i++)
+			{
+				if((d->from ^ d->to) & BIT(i))
+				{
+					fb_set(d->index + i, (d->to & BIT(i)) ? anim->color : FB_INDEX_OFF);
+				}
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ANIM_H_
+#define ANIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Digits of one team that can change in the same frame */
+#define ANIM_MAX_DIGITS 4
+
+struct anim_digit {
+	uint16_t index;
+	uint32_t from;
+	uint32_t to;
+	uint8_t len;
+};
+
+/**
+ * @brief Digit transitions of one team color.
+ *
+ * The digits share the @p in and @p out palette entries, so every digit of
+ * the team moves in step.
+ */
+struct anim {
+	/* Palette entries, set by the owner */
+	uint8_t color;
+	uint8_t in;
+	uint8_t out;
+
+	struct anim_digit digits[ANIM_MAX_DIGITS];
+	uint8_t num_digits;
+	uint16_t frame;
+	bool active;
+};
+
+/**
+ * @brief Change a digit, animated if a transition style is configured.
+ *
+ * Digits changed before the next anim_step() start together. A change after
+ * that first ends the running transition, so a newer score is never held back.
+ *
+ * @param anim Team transitions.
+ * @param index First pixel of the digit.
+ * @param len Pixels in the digit, at most 32.
+ * @param glyph Lit pixels of the new glyph, bit 0 is @p index.
+ */
+void anim_digit(struct anim *anim, uint16_t index, uint8_t len, uint32_t glyph);
+
+/**
+ * @brief Advance the transitions by one frame.
+ *
+ * The work per frame does not depend on the chain length: the fades only
+ * set the two palette entries, the wipe sets at most the differing pixels of
+ * ANIM_MAX_DIGITS digits.
+ *
+ * @return true if the frame changed and has to be committed.
+ */
+bool anim_step(struct anim *anim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ANIM_H_ */
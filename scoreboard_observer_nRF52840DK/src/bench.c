@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Cycle benchmarks of the commit path, run from the shell on the live frame.
+ *
+ * Interrupts stay enabled so the radio keeps running, the minimum over the
+ * runs is the figure to compare.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <stdlib.h>
+#include <string.h>
+#include "color.h"
+#include "framebuffer.h"
+#include "pixel.h"
+
+#define BENCH_RUNS_DEFAULT 100
+#define BENCH_MAX_PIXELS   1000
+
+struct bench_result {
+	uint32_t min;
+	uint32_t sum;
+};
+
+static struct led_rgb bench_pixels[FB_NUM_PIXELS];
+static uint8_t bench_lut[256];
+
+/* Chain lengths for the pixel kernels, from the DK board to a large wall */
+static const uint16_t bench_lengths[] = { 88, 144, 300, 600, BENCH_MAX_PIXELS };
+
+static uint8_t bench_from[BENCH_MAX_PIXELS * 3];
+static uint8_t bench_to[BENCH_MAX_PIXELS * 3];
+static uint8_t bench_out[BENCH_MAX_PIXELS * 3];
+
+static void bench_add(struct bench_result *res, uint32_t start_cyc)
+{
+	uint32_t cyc = k_cycle_get_32() - start_cyc;
+
+	res->min = MIN(res->min, cyc);
+	res->sum += cyc;
+}
+
+static void bench_print(const struct shell *sh, const char *name,
+			const struct bench_result *res, uint32_t runs, uint32_t pixels)
+{
+	shell_print(sh, "%-28s min %6u avg %6u cycles, %u.%02u per pixel", name,
+		    res->min, res->sum / runs, res->min / pixels,
+		    (res->min % pixels) * 100 / pixels);
+}
+
+static int cmd_bench_commit(const struct shell *sh, size_t argc, char **argv)
+{
+	struct bench_result expand = { .min = UINT32_MAX };
+	struct bench_result sweep = { .min = UINT32_MAX };
+	struct bench_result stage = { .min = UINT32_MAX };
+	struct led_rgb palette[FB_PALETTE_SIZE];
+	struct led_rgb corrected[FB_PALETTE_SIZE];
+	uint16_t counts[FB_PALETTE_SIZE];
+	uint32_t runs = BENCH_RUNS_DEFAULT;
+	uint32_t current_ma;
+	uint32_t start_cyc;
+
+	if(argc > 1)
+	{
+		runs = CLAMP(strtoul(argv[1], NULL, 0), 1, 10000);
+	}
+
+	for(uint16_t i = 0; i < ARRAY_SIZE(bench_lut); i++)
+	{
+		bench_lut[i] = i;
+	}
+
+	for(uint8_t i = 0; i < FB_PALETTE_SIZE; i++)
+	{
+		palette[i] = (struct led_rgb){ .r = i * 16, .g = 0xFF - i * 16, .b = i };
+		counts[i] = FB_NUM_PIXELS / FB_PALETTE_SIZE;
+	}
+
+	for(uint32_t n = 0; n < runs; n++)
+	{
+		/* Color stage on the palette, the only correction cost per frame */
+		start_cyc = k_cycle_get_32();
+		(void)color_apply(palette, counts, corrected, FB_PALETTE_SIZE);
+		bench_add(&stage, start_cyc);
+
+		/* What fb_commit() does before the transfer */
+		start_cyc = k_cycle_get_32();
+		fb_expand(bench_pixels, &current_ma);
+		bench_add(&expand, start_cyc);
+
+		/* The same correction as a second pass over the pixels */
+		start_cyc = k_cycle_get_32();
+		for(uint16_t i = 0; i < FB_NUM_PIXELS; i++)
+		{
+			bench_pixels[i].r = bench_lut[bench_pixels[i].r];
+			bench_pixels[i].g = bench_lut[bench_pixels[i].g];
+			bench_pixels[i].b = bench_lut[bench_pixels[i].b];
+		}
+		bench_add(&sweep, start_cyc);
+	}
+
+	shell_print(sh, "%u pixels, %u bpp, %u runs, %u Hz cycle clock", FB_NUM_PIXELS,
+		    FB_BPP, runs, sys_clock_hw_cycles_per_sec());
+	bench_print(sh, "palette color stage", &stage, runs, FB_NUM_PIXELS);
+	bench_print(sh, "expand with color stage", &expand, runs, FB_NUM_PIXELS);
+	bench_print(sh, "per-pixel LUT pass (ref)", &sweep, runs, FB_NUM_PIXELS);
+	shell_print(sh, "frame current %u mA before limiting", current_ma);
+
+	return 0;
+}
+
+enum bench_kernel {
+	KERNEL_SCALE,
+	KERNEL_CROSSFADE,
+	KERNEL_FADE,
+};
+
+static const char *const kernel_names[] = { "scale", "crossfade", "fade" };
+
+static uint32_t bench_kernel(enum bench_kernel kernel, bool simd, size_t len, uint32_t runs)
+{
+	uint32_t min = UINT32_MAX;
+
+	for(uint32_t n = 0; n < runs; n++)
+	{
+		uint32_t start_cyc;
+
+		memcpy(bench_out, bench_from, len);
+		start_cyc = k_cycle_get_32();
+
+		switch(kernel)
+		{
+		case KERNEL_SCALE:
+			if(simd)
+			{
+				pixel_scale(bench_out, len, 0x80);
+			}
+			else
+			{
+				pixel_scale_scalar(bench_out, len, 0x80);
+			}
+			break;
+		case KERNEL_CROSSFADE:
+			if(simd)
+			{
+				pixel_crossfade(bench_out, bench_from, bench_to, len, 100);
+			}
+			else
+			{
+				pixel_crossfade_scalar(bench_out, bench_from, bench_to, len, 100);
+			}
+			break;
+		case KERNEL_FADE:
+			if(simd)
+			{
+				pixel_fade(bench_out, len, 8);
+			}
+			else
+			{
+				pixel_fade_scalar(bench_out, len, 8);
+			}
+			break;
+		}
+
+		min = MIN(min, k_cycle_get_32() - start_cyc);
+	}
+
+	return min;
+}
+
+static int cmd_bench_pixel(const struct shell *sh, size_t argc, char **argv)
+{
+	uint32_t runs = BENCH_RUNS_DEFAULT;
+
+	if(argc > 1)
+	{
+		runs = CLAMP(strtoul(argv[1], NULL, 0), 1, 10000);
+	}
+
+	for(size_t i = 0; i < sizeof(bench_from); i++)
+	{
+		bench_from[i] = i * 7;
+		bench_to[i] = 0xFF - i * 3;
+	}
+
+	shell_print(sh, "%s kernels, min cycles over %u runs",
+		    PIXEL_SIMD ? "SIMD" : "scalar (no DSP)", runs);
+	shell_print(sh, "%-6s %-10s %8s %8s %6s", "pixels", "kernel", "scalar", "simd", "x");
+
+	for(size_t i = 0; i < ARRAY_SIZE(bench_lengths); i++)
+	{
+		size_t len = bench_lengths[i] * 3;
+
+		for(uint8_t k = 0; k < ARRAY_SIZE(kernel_names); k++)
+		{
+			uint32_t scalar = bench_kernel(k, false, len, runs);
+			uint32_t simd = bench_kernel(k, true, len, runs);
+
+			shell_print(sh, "%-6u %-10s %8u %8u %3u.%02u", bench_lengths[i],
+				    kernel_names[k], scalar, simd, scalar / MAX(simd, 1),
+				    (scalar % MAX(simd, 1)) * 100 / MAX(simd, 1));
+		}
+	}
+
+	return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(bench_cmds,
+	SHELL_CMD_ARG(commit, NULL, "Commit path stages [runs]", cmd_bench_commit, 1, 1),
+	SHELL_CMD_ARG(pixel, NULL, "Pixel kernels, SIMD against scalar [runs]",
+		      cmd_bench_pixel, 1, 1),
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(bench, &bench_cmds, "Scoreboard observer benchmarks", NULL);
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* GATT client of the scoreboard service.
+ *
+ * The broadcaster advertises the service on a connectable set. Once it is
+ * seen, the observer connects, finds the score characteristic and subscribes
+ * to it. Score changes then arrive as notifications within a connection
+ * interval, next to the advertising reports that keep coming in. Both feed
+ * the same score update, the one that is late is a stale report. When the
+ * connection drops, advertising alone carries on and the service is
+ * connected to again when it is seen.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/hci.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <string.h>
+#include <scoreboard_proto.h>
+#include <sb_trace.h>
+#include "central.h"
+
+LOG_MODULE_DECLARE(observer, LOG_LEVEL_INF);
+
+/* Connection interval 7.5 ms to 15 ms, in 1.25 ms units */
+#define CONN_INTERVAL_MIN 6
+#define CONN_INTERVAL_MAX 12
+#define CONN_TIMEOUT      400 /* 4 s, in 10 ms units */
+
+static const struct bt_uuid_128 service_uuid = BT_UUID_INIT_128(SB_GATT_SERVICE_UUID_VAL);
+static const struct bt_uuid_128 score_uuid = BT_UUID_INIT_128(SB_GATT_SCORE_UUID_VAL);
+
+static const struct bt_le_scan_param *scan_param;
+static central_score_cb_t score_cb;
+
+/* Written by the BT RX thread only */
+static struct bt_conn *conn;
+static struct bt_gatt_discover_params discover_params;
+static struct bt_gatt_discover_params ccc_discover_params;
+static struct bt_gatt_subscribe_params subscribe_params;
+
+static atomic_t subscribed;
+
+static void scan_restart(void)
+{
+	int err;
+
+	err = bt_le_scan_start(scan_param, NULL);
+	if (err && (err != -EALREADY)) {
+		LOG_ERR("Restart scanning failed (err %d)", err);
+	}
+}
+
+static uint8_t score_notify(struct bt_conn *c, struct bt_gatt_subscribe_params *params,
+			    const void *data, uint16_t length)
+{
+	if (!data) {
+		/* Unsubscribed, the connection is going away */
+		atomic_clear(&subscribed);
+		params->value_handle = 0;
+		return BT_GATT_ITER_STOP;
+	}
+
+	SB_TRACE_BEGIN(SB_TRACE_GATT_RX, length);
+	score_cb(data, length);
+	SB_TRACE_END(SB_TRACE_GATT_RX, length);
+
+	return BT_GATT_ITER_CONTINUE;
+}
+
+static uint8_t discover_func(struct bt_conn *c, const struct bt_gatt_attr *attr,
+			     struct bt_gatt_discover_params *params)
+{
+	const struct bt_gatt_chrc *chrc;
+	int err;
+
+	if (!attr) {
+		LOG_WRN("Score characteristic not found");
+		return BT_GATT_ITER_STOP;
+	}
+
+	chrc = attr->user_data;
+
+	subscribe_params.notify = score_notify;
+	subscribe_params.value = BT_GATT_CCC_NOTIFY;
+	subscribe_params.value_handle = chrc->value_handle;
+	subscribe_params.ccc_handle = BT_GATT_AUTO_DISCOVER_CCC_HANDLE;
+	subscribe_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+	subscribe_params.disc_params = &ccc_discover_params;
+
+	err = bt_gatt_subscribe(c, &subscribe_params);
+	if (err && (err != -EALREADY)) {
+		LOG_ERR("Subscribe failed (err %d)", err);
+	} else {
+		atomic_set(&subscribed, 1);
+	}
+
+	return BT_GATT_ITER_STOP;
+}
+
+static bool uuid_cb(struct bt_data *data, void *user_data)
+{
+	bool *found = user_data;
+
+	if (data->type != BT_DATA_UUID128_ALL && data->type != BT_DATA_UUID128_SOME) {
+		return true;
+	}
+
+	for (uint8_t i = 0; i + BT_UUID_SIZE_128 <= data->data_len; i += BT_UUID_SIZE_128) {
+		if (memcmp(&data->data[i], service_uuid.val, BT_UUID_SIZE_128) == 0) {
+			*found = true;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void scan_recv(const struct bt_le_scan_recv_info *info, struct net_buf_simple *ad)
+{
+	static const struct bt_le_conn_param param =
+		BT_LE_CONN_PARAM_INIT(CONN_INTERVAL_MIN, CONN_INTERVAL_MAX, 0, CONN_TIMEOUT);
+	bool found = false;
+	int err;
+
+	if (conn || (info->sid != SB_ADV_SID_GATT) ||
+	    !(info->adv_props & BT_GAP_ADV_PROP_CONNECTABLE)) {
+		return;
+	}
+
+	bt_data_parse(ad, uuid_cb, &found);
+	if (!found) {
+		return;
+	}
+
+	/* The controller cannot scan and initiate at the same time */
+	err = bt_le_scan_stop();
+	if (err) {
+		return;
+	}
+
+	err = bt_conn_le_create(info->addr, BT_CONN_LE_CREATE_CONN, &param, &conn);
+	if (err) {
+		LOG_ERR("Create connection failed (err %d)", err);
+		scan_restart();
+	}
+}
+
+static struct bt_le_scan_cb scan_callbacks = {
+	.recv = scan_recv,
+};
+
+static void connected(struct bt_conn *c, uint8_t err)
+{
+	if (c != conn) {
+		return;
+	}
+
+	/* Scan again whether or not the connection was made, advertising
+	 * stays the fallback
+	 */
+	scan_restart();
+
+	if (err) {
+		bt_conn_unref(conn);
+		conn = NULL;
+		return;
+	}
+
+	discover_params.uuid = &score_uuid.uuid;
+	discover_params.func = discover_func;
+	discover_params.start_handle = BT_ATT_FIRST_ATTRIBUTE_HANDLE;
+	discover_params.end_handle = BT_ATT_LAST_ATTRIBUTE_HANDLE;
+	discover_params.type = BT_GATT_DISCOVER_CHARACTERISTIC;
+
+	err = bt_gatt_discover(conn, &discover_params);
+	if (err) {
+		LOG_ERR("Discover failed (err %d)", err);
+		(void)bt_conn_disconnect(conn, BT_HCI_ERR_REMOTE_USER_TERM_CONN);
+	}
+}
+
+static void disconnected(struct bt_conn *c, uint8_t reason)
+{
+	if (c != conn) {
+		return;
+	}
+
+	atomic_clear(&subscribed);
+	bt_conn_unref(conn);
+	conn = NULL;
+
+	/* Scanning went on while connected. Restarting it clears the duplicate
+	 * filter, which hides the unchanged connectable set otherwise.
+	 */
+	(void)bt_le_scan_stop();
+	scan_restart();
+}
+
+BT_CONN_CB_DEFINE(central_conn_callbacks) = {
+	.connected = connected,
+	.disconnected = disconnected,
+};
+
+void central_init(const struct bt_le_scan_param *param, central_score_cb_t cb)
+{
+	scan_param = param;
+	score_cb = cb;
+
+	bt_le_scan_cb_register(&scan_callbacks);
+}
+
+bool central_subscribed(void)
+{
+	return atomic_get(&subscribed) != 0;
+}
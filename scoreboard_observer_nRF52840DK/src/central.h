@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CENTRAL_H_
+#define CENTRAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Score notification callback, called from the Bluetooth RX thread.
+ *
+ * @param data struct sb_score.
+ * @param len Length of @p data.
+ */
+typedef void (*central_score_cb_t)(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Connect to the scoreboard GATT service when it is advertised.
+ *
+ * Scanning is stopped while a connection is created and restarted with
+ * @p param, so advertising keeps being received while connected and after
+ * the connection drops.
+ *
+ * @param param Scan parameters of the observer, must stay valid.
+ * @param score_cb Called for every score notification.
+ */
+void central_init(const struct bt_le_scan_param *param, central_score_cb_t score_cb);
+
+/** @brief true while subscribed to the score characteristic. */
+bool central_subscribed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CENTRAL_H_ */
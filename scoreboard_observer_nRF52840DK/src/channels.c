@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/zbus/zbus.h>
+#include "channels.h"
+#include "stats.h"
+
+ZBUS_CHAN_DEFINE(score_chan, struct score_state, NULL, &stats_hists.score_pub_us,
+		 ZBUS_OBSERVERS_EMPTY, ZBUS_MSG_INIT(0));
+
+ZBUS_CHAN_DEFINE(render_req_chan, struct render_req, NULL, &stats_hists.render_req_pub_us,
+		 ZBUS_OBSERVERS_EMPTY, ZBUS_MSG_INIT(0));
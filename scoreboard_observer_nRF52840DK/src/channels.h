@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* zbus channels between the radio and the display.
+ *
+ * score_chan       struct score_state, the newest score from any path and
+ *                  the score on the display. Changed in place under
+ *                  zbus_chan_claim(), subscribers are notified of every new
+ *                  score received.
+ * render_req_chan  struct render_req, the changes the render thread picks
+ *                  up at its next frame tick. Requests are or-ed into the
+ *                  message, so none is lost to a later one.
+ *
+ * The render thread reads both at the frame tick and never blocks on
+ * them. Loggers and other consumers attach with zbus_chan_add_obs(). Every
+ * channel keeps its publish latency in a histogram of the same name.
+ */
+
+#ifndef CHANNELS_H_
+#define CHANNELS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/zbus/zbus.h>
+#include <scoreboard_proto.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct score_state {
+	struct sb_score score; /* Newest score received */
+	struct sb_score shown; /* Score on the display, written by the render thread */
+	uint16_t seq;          /* Broadcaster score sequence, as last received over PAwR */
+	int64_t apply_ticks;   /* Uptime in ticks at which score is shown, 0 for the next frame */
+	bool apply_pawr;       /* apply_ticks came from a PAwR subevent */
+};
+
+enum render_req_bit {
+	RENDER_SCORE,
+	RENDER_MATCH,
+};
+
+struct render_req {
+	uint32_t pending; /* BIT(enum render_req_bit) */
+};
+
+ZBUS_CHAN_DECLARE(score_chan, render_req_chan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHANNELS_H_ */
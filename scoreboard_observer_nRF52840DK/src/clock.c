@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* The broadcaster only advertises the clock on start, stop and adjust, plus a
+ * slow re-anchor while running. In between the clock is interpolated from
+ * the local uptime.
+ *
+ * The broadcaster uptime is mapped to the local one with an offset, the
+ * difference between the local reception time and the anchor time. Each
+ * sample includes the unknown advertising and scanning delay, so the offset
+ * used is the smallest of the last CLOCK_OFFSET_WINDOW samples.
+ *
+ * Only an anchor that changed while the match record was being received
+ * gives a sample. The first anchor a display hears may have been set long
+ * before, it is used with a provisional offset until the next re-anchor.
+ * An anchor older than the last one means the broadcaster restarted, its
+ * uptime went back and the samples are dropped.
+ *
+ * The anchor and offset are written by the Bluetooth RX thread and read by
+ * the render thread, under clock_lock.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <stdlib.h>
+#include "clock.h"
+
+#define CLOCK_OFFSET_WINDOW 8
+
+/* Anchor adjustments are whole seconds, anything below is drift */
+#define CLOCK_DRIFT_MAX_MS 500
+
+/* A changed anchor is fresh if the previous match record came this recently.
+ * The match record set is advertised every 200 ms.
+ */
+#define CLOCK_FRESH_MS 1000
+
+static struct sb_clock_anchor anchor = {
+	.rate = SB_CLOCK_RATE_REALTIME,
+};
+
+static int32_t offset_samples[CLOCK_OFFSET_WINDOW];
+static uint8_t offset_count;
+static uint8_t offset_next;
+static int32_t offset_ms;
+static bool offset_provisional = true;
+static uint32_t last_rx_ms;
+static bool rx_seen;
+
+static struct k_spinlock clock_lock;
+
+static int32_t drift_last_ms;
+static int32_t drift_max_ms;
+
+static void offset_reset(void)
+{
+	offset_count = 0;
+	offset_next = 0;
+}
+
+static void offset_add(int32_t sample)
+{
+	offset_samples[offset_next] = sample;
+	offset_next = (offset_next + 1) % CLOCK_OFFSET_WINDOW;
+	offset_count = MIN(offset_count + 1, CLOCK_OFFSET_WINDOW);
+
+	offset_ms = offset_samples[0];
+	for (uint8_t i = 1; i < offset_count; i++) {
+		offset_ms = MIN(offset_ms, offset_samples[i]);
+	}
+}
+
+static uint32_t anchor_value(const struct sb_clock_anchor *a, int32_t offset,
+			     uint32_t now_ms)
+{
+	int32_t elapsed_ms;
+	uint32_t elapsed_ds;
+
+	if (!(a->flags & SB_CLOCK_FLAG_RUNNING)) {
+		return a->value_ds;
+	}
+
+	/* Broadcaster uptime now, relative to the anchor */
+	elapsed_ms = (int32_t)(now_ms - offset - a->anchor_ms);
+	if (elapsed_ms <= 0) {
+		return a->value_ds;
+	}
+
+	elapsed_ds = (uint64_t)elapsed_ms * a->rate / (100U * SB_CLOCK_RATE_REALTIME);
+
+	if (!(a->flags & SB_CLOCK_FLAG_COUNT_DOWN)) {
+		return a->value_ds + elapsed_ds;
+	}
+
+	return (elapsed_ds >= a->value_ds) ? 0 : a->value_ds - elapsed_ds;
+}
+
+bool clock_anchor_update(const struct sb_tlv *tlv)
+{
+	const struct sb_clock_anchor *rx;
+	struct sb_clock_anchor new_anchor;
+	uint32_t now_ms = k_uptime_get_32();
+	int32_t old_offset = offset_ms;
+	bool old_measured = !offset_provisional;
+	int32_t drift_ms;
+	bool fresh;
+	k_spinlock_key_t key;
+
+	if (tlv->len != sizeof(*rx)) {
+		return false;
+	}
+
+	rx = (const struct sb_clock_anchor *)tlv->value;
+	new_anchor.flags = rx->flags;
+	new_anchor.value_ds = sys_le32_to_cpu(rx->value_ds);
+	new_anchor.anchor_ms = sys_le32_to_cpu(rx->anchor_ms);
+	new_anchor.rate = sys_le16_to_cpu(rx->rate);
+
+	fresh = rx_seen && ((now_ms - last_rx_ms) <= CLOCK_FRESH_MS);
+	rx_seen = true;
+	last_rx_ms = now_ms;
+
+	if (memcmp(&anchor, &new_anchor, sizeof(anchor)) == 0) {
+		return false;
+	}
+
+	key = k_spin_lock(&clock_lock);
+
+	if ((int32_t)(new_anchor.anchor_ms - anchor.anchor_ms) < 0) {
+		offset_reset();
+		offset_provisional = true;
+		old_measured = false;
+		fresh = false;
+	}
+
+	if (fresh) {
+		if (offset_provisional) {
+			offset_reset();
+			offset_provisional = false;
+		}
+		offset_add((int32_t)(now_ms - new_anchor.anchor_ms));
+	} else if (offset_provisional) {
+		offset_ms = (int32_t)(now_ms - new_anchor.anchor_ms);
+	}
+
+	if (fresh && old_measured && (anchor.flags & SB_CLOCK_FLAG_RUNNING) &&
+	    (new_anchor.flags & SB_CLOCK_FLAG_RUNNING)) {
+		drift_ms = ((int32_t)anchor_value(&anchor, old_offset, now_ms) -
+			    (int32_t)anchor_value(&new_anchor, offset_ms, now_ms)) * 100;
+		if (abs(drift_ms) < CLOCK_DRIFT_MAX_MS) {
+			drift_last_ms = drift_ms;
+			if (abs(drift_ms) > abs(drift_max_ms)) {
+				drift_max_ms = drift_ms;
+			}
+		}
+	}
+
+	anchor = new_anchor;
+
+	k_spin_unlock(&clock_lock, key);
+
+	return true;
+}
+
+uint32_t clock_value_ds(uint32_t now_ms)
+{
+	struct sb_clock_anchor a;
+	int32_t offset;
+	k_spinlock_key_t key = k_spin_lock(&clock_lock);
+
+	a = anchor;
+	offset = offset_ms;
+	k_spin_unlock(&clock_lock, key);
+
+	return anchor_value(&a, offset, now_ms);
+}
+
+bool clock_running(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&clock_lock);
+	bool running = anchor.flags & SB_CLOCK_FLAG_RUNNING;
+
+	k_spin_unlock(&clock_lock, key);
+
+	return running;
+}
+
+void clock_drift_get(int32_t *last_ms, int32_t *max_ms)
+{
+	k_spinlock_key_t key = k_spin_lock(&clock_lock);
+
+	*last_ms = drift_last_ms;
+	*max_ms = drift_max_ms;
+	k_spin_unlock(&clock_lock, key);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <scoreboard_proto.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Take a clock anchor TLV from the match record.
+ *
+ * @param tlv SB_TLV_CLOCK TLV.
+ *
+ * @return true if the anchor changed.
+ */
+bool clock_anchor_update(const struct sb_tlv *tlv);
+
+/**
+ * @brief Match clock value interpolated from the last anchor.
+ *
+ * @param now_ms Local uptime in milliseconds.
+ *
+ * @return Clock value in tenths of a second.
+ */
+uint32_t clock_value_ds(uint32_t now_ms);
+
+/** @brief true while the match clock is running. */
+bool clock_running(void);
+
+/**
+ * @brief Drift between the local interpolation and the broadcaster.
+ *
+ * Measured when a re-anchor of a running clock arrives.
+ *
+ * @param last_ms Drift at the last re-anchor, positive if the local clock ran ahead.
+ * @param max_ms Largest absolute drift seen.
+ */
+void clock_drift_get(int32_t *last_ms, int32_t *max_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLOCK_H_ */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Color post-processing at commit time.
+ *
+ * The frame is palette indexed, so the gamma, brightness and current limit
+ * are applied to the palette entries instead of the pixels. The expansion
+ * in fb_commit() then writes corrected colors in its only pass over the
+ * frame, whatever the chain length.
+ *
+ * The current model is linear in the PWM duty cycle: every channel draws
+ * CONFIG_SCOREBOARD_LED_CHANNEL_MA at 255, plus CONFIG_SCOREBOARD_LED_IDLE_UA
+ * per LED.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include "color.h"
+
+/* round(255 * (i / 255)^2.2) */
+static const uint8_t gamma_22[256] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+	  1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+	  3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+	  6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+	 12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+	 20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+	 30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+	 42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+	 56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+	 73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+	 91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+	113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+	137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+	163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+	192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+	223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+/* Gamma and brightness in one lookup, rebuilt on brightness changes */
+static uint8_t lut[256];
+
+void color_set_brightness(uint8_t brightness)
+{
+	for(uint16_t i = 0; i < ARRAY_SIZE(lut); i++)
+	{
+		uint16_t v = IS_ENABLED(CONFIG_SCOREBOARD_GAMMA) ? gamma_22[i] : i;
+
+		lut[i] = (v * brightness + 127) / 255;
+	}
+}
+
+void color_init(void)
+{
+	color_set_brightness(CONFIG_SCOREBOARD_BRIGHTNESS);
+}
+
+uint32_t color_apply(const struct led_rgb *in, const uint16_t *counts,
+		     struct led_rgb *out, size_t n)
+{
+	uint32_t num_pixels = 0;
+	uint32_t duty = 0;
+	uint32_t lit_ma;
+	uint32_t idle_ma;
+	uint32_t avail_ma;
+	uint32_t scale;
+
+	for(size_t i = 0; i < n; i++)
+	{
+		out[i].r = lut[in[i].r];
+		out[i].g = lut[in[i].g];
+		out[i].b = lut[in[i].b];
+
+		num_pixels += counts[i];
+		duty += counts[i] * (uint32_t)(out[i].r + out[i].g + out[i].b);
+	}
+
+	lit_ma = duty * CONFIG_SCOREBOARD_LED_CHANNEL_MA / 255;
+	idle_ma = num_pixels * CONFIG_SCOREBOARD_LED_IDLE_UA / 1000;
+
+	if((CONFIG_SCOREBOARD_CURRENT_LIMIT_MA == 0) || (lit_ma == 0) ||
+	   (lit_ma + idle_ma <= CONFIG_SCOREBOARD_CURRENT_LIMIT_MA))
+	{
+		return lit_ma + idle_ma;
+	}
+
+	/* Scale every entry by the same Q8 factor so the hues stay */
+	avail_ma = (CONFIG_SCOREBOARD_CURRENT_LIMIT_MA > idle_ma) ?
+		   CONFIG_SCOREBOARD_CURRENT_LIMIT_MA - idle_ma : 0;
+	scale = (avail_ma << 8) / lit_ma;
+
+	for(size_t i = 0; i < n; i++)
+	{
+		out[i].r = (out[i].r * scale) >> 8;
+		out[i].g = (out[i].g * scale) >> 8;
+		out[i].b = (out[i].b * scale) >> 8;
+	}
+
+	return lit_ma + idle_ma;
+}
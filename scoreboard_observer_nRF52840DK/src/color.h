@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef COLOR_H_
+#define COLOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/drivers/led_strip.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* True if a frame drawing @p _ma is dimmed by color_apply() */
+#define COLOR_LIMITED(_ma) ((CONFIG_SCOREBOARD_CURRENT_LIMIT_MA != 0) && \
+			    ((_ma) > CONFIG_SCOREBOARD_CURRENT_LIMIT_MA))
+
+/** @brief Build the gamma and brightness LUT from Kconfig. */
+void color_init(void);
+
+/**
+ * @brief Set the global brightness.
+ *
+ * Rebuilds the 256 entry LUT, takes effect at the next commit.
+ */
+void color_set_brightness(uint8_t brightness);
+
+/**
+ * @brief Correct a palette for the wire and keep the frame under the supply
+ * budget.
+ *
+ * Each entry goes through the gamma and brightness LUT. The frame current
+ * is estimated from the number of pixels drawn with each entry. Above
+ * CONFIG_SCOREBOARD_CURRENT_LIMIT_MA all entries are scaled down by the
+ * same factor.
+ *
+ * @param in Palette as drawn.
+ * @param counts Number of pixels per palette entry.
+ * @param out Palette to expand the frame with.
+ * @param n Number of palette entries.
+ *
+ * @return Estimated frame current in mA before limiting.
+ */
+uint32_t color_apply(const struct led_rgb *in, const uint16_t *counts,
+		     struct led_rgb *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_H_ */
@@ -0,0 +1,510 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Frame scheduler for the LED strips.
+ *
+ * A k_timer ticks at CONFIG_SCOREBOARD_FPS. Widget setters only record the
+ * new value and mark the widget dirty. Once per tick the dirty widgets are
+ * drawn as palette indices into the framebuffer and every strip gets a
+ * single transfer, or none if nothing changed. Team colors live in the palette, so
+ * changing them only needs a commit. Team digits change through the
+ * transitions in anim.c, which keep committing frames until they end.
+ * Where each widget sits on the chain comes from the devicetree, see
+ * layout.c.
+ *
+ * Text widgets show a text rasterized through the font when it is set.
+ * Scrolling moves an offset into those glyphs, so no character is looked
+ * up again while a text scrolls.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/led_strip.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include <scoreboard_proto.h>
+#include <sb_trace.h>
+#include "anim.h"
+#include "clock.h"
+#include "color.h"
+#include "display.h"
+#include "framebuffer.h"
+#include "layout.h"
+#include "stats.h"
+
+#define CLOCK_NUM_DIGITS   4
+
+#define FRAME_PERIOD_US    DISPLAY_FRAME_PERIOD_US
+
+#define TEXT_MAX_LEN       MAX(SB_TEAM_NAME_MAX_LEN, SB_MESSAGE_MAX_LEN)
+
+/* Blank cells between the end of a scrolling text and its start */
+#define TEXT_GAP           3
+
+#define RGB(_r, _g, _b) ((struct led_rgb){ .r = (_r), .g = (_g), .b = (_b) })
+
+/* Palette indices, see framebuffer.h */
+enum palette_index {
+	PAL_OFF,
+	PAL_HOME,
+	PAL_GUEST,
+	PAL_CLOCK,
+	PAL_HOME_IN,
+	PAL_HOME_OUT,
+	PAL_GUEST_IN,
+	PAL_GUEST_OUT,
+};
+
+BUILD_ASSERT(IS_ENABLED(CONFIG_SCOREBOARD_ANIM_NONE) || (FB_PALETTE_SIZE > PAL_GUEST_OUT),
+	     "Digit transitions need a 4 bpp framebuffer");
+
+/* Widget values, written by the setters and read when rendering. Both run on
+ * the render thread.
+ */
+static uint16_t points[2];
+static uint8_t sets[2];
+static uint8_t serving;
+static uint8_t clock_digits[CLOCK_NUM_DIGITS];
+static uint32_t dirty;
+static bool palette_dirty;
+
+/* Brightness set from another thread, taken at the next frame, or -1 */
+static atomic_t brightness_req = ATOMIC_INIT(-1);
+
+static struct anim anims[] = {
+	[LAYOUT_TEAM_HOME] = { .color = PAL_HOME, .in = PAL_HOME_IN, .out = PAL_HOME_OUT },
+	[LAYOUT_TEAM_GUEST] = { .color = PAL_GUEST, .in = PAL_GUEST_IN, .out = PAL_GUEST_OUT },
+};
+
+static const uint8_t team_colors[] = {
+	[LAYOUT_TEAM_HOME] = PAL_HOME,
+	[LAYOUT_TEAM_GUEST] = PAL_GUEST,
+};
+
+struct text {
+	/* Glyphs of the text followed by TEXT_GAP blanks */
+	uint32_t glyphs[TEXT_MAX_LEN + TEXT_GAP];
+	uint8_t len;
+	uint8_t offset;
+	/* Cells of the narrowest widget showing the text */
+	uint8_t cells;
+};
+
+static struct text texts[LAYOUT_TEXT_COUNT];
+static uint32_t text_step_ms;
+
+static const uint8_t text_colors[] = {
+	[LAYOUT_TEXT_HOME_NAME] = PAL_HOME,
+	[LAYOUT_TEXT_GUEST_NAME] = PAL_GUEST,
+	[LAYOUT_TEXT_MESSAGE] = PAL_CLOCK,
+};
+
+K_TIMER_DEFINE(frame_timer, NULL, NULL);
+
+static uint32_t frame_start_cyc;
+
+/* Uptime in ticks the next commit waits for, 0 for none */
+static int64_t commit_at_ticks;
+static uint32_t commit_late_us;
+
+static void draw_glyph(uint16_t index, uint32_t glyph, uint8_t color)
+{
+	uint8_t i;
+
+	for(i = 0; i < LAYOUT_LEDS_PER_DIGIT; i++)
+	{
+		if(glyph & BIT(i))
+		{
+			fb_set(i + index, color);
+		}
+		else
+		{
+			fb_set(i + index, PAL_OFF);
+		}
+	}
+}
+
+/* Least significant digit first, leading zeros blanked if the widget asks.
+ * A value with more digits than the widget shows all nines.
+ */
+static void render_number(const struct layout_widget *w, uint32_t value)
+{
+	uint32_t max = 1;
+
+	for(uint8_t j = 0; j < w->num_digits; j++)
+	{
+		max *= 10;
+	}
+
+	if(value >= max)
+	{
+		value = max - 1;
+		STATS_INC(digits_clamped);
+	}
+
+	for(uint8_t j = 0; j < w->num_digits; j++)
+	{
+		uint8_t glyph = value % 10;
+
+		if(w->blank_zeros && (j > 0) && (value == 0))
+		{
+			glyph = LAYOUT_GLYPH_BLANK;
+		}
+
+		anim_digit(&anims[w->team], w->digits[j], LAYOUT_LEDS_PER_DIGIT,
+			   layout_glyphs[glyph]);
+		value /= 10;
+	}
+}
+
+static void render_serving(const struct layout_widget *w)
+{
+	uint8_t team = (serving & TEAM_HOME_SERVING_BIT) ? LAYOUT_TEAM_HOME : LAYOUT_TEAM_GUEST;
+	bool lit = (serving & (TEAM_HOME_SERVING_BIT | TEAM_GUEST_SERVING_BIT)) && (w->team == team);
+
+	fb_fill(w->start, w->len, lit ? team_colors[w->team] : PAL_OFF);
+}
+
+static void render_clock(const struct layout_widget *w)
+{
+	for(uint8_t j = 0; j < MIN(w->num_digits, CLOCK_NUM_DIGITS); j++)
+	{
+		draw_glyph(w->digits[j], layout_glyphs[clock_digits[j]], PAL_CLOCK);
+	}
+}
+
+static void render_text(const struct layout_widget *w)
+{
+	const struct text *t = &texts[w->text];
+	bool scrolls = t->len > w->num_digits;
+
+	for(uint8_t j = 0; j < w->num_digits; j++)
+	{
+		uint32_t glyph = 0;
+
+		if(scrolls)
+		{
+			glyph = t->glyphs[(t->offset + j) % (t->len + TEXT_GAP)];
+		}
+		else if(j < t->len)
+		{
+			glyph = t->glyphs[j];
+		}
+
+		draw_glyph(w->digits[j], glyph, text_colors[w->text]);
+	}
+}
+
+static void render_widgets(uint32_t types)
+{
+	for(size_t i = 0; i < layout_num_widgets; i++)
+	{
+		const struct layout_widget *w = &layout_widgets[i];
+
+		if((types & BIT(w->type)) == 0)
+		{
+			continue;
+		}
+
+		switch(w->type)
+		{
+		case LAYOUT_POINTS:
+			render_number(w, points[w->team]);
+			break;
+		case LAYOUT_SETS:
+			render_number(w, sets[w->team]);
+			break;
+		case LAYOUT_SERVING:
+			render_serving(w);
+			break;
+		case LAYOUT_CLOCK:
+			render_clock(w);
+			break;
+		case LAYOUT_TEXT:
+			render_text(w);
+			break;
+		}
+	}
+}
+
+/* Shows mm:ss from one minute up and ss.t below */
+static void update_clock(void)
+{
+	uint32_t value_ds;
+	uint32_t seconds;
+	uint8_t d[CLOCK_NUM_DIGITS];
+
+	if(!LAYOUT_HAS_CLOCK)
+	{
+		return;
+	}
+
+	value_ds = clock_value_ds(k_uptime_get_32());
+	seconds = value_ds / 10;
+
+	if(seconds >= 60)
+	{
+		d[0] = (seconds % 60) % 10;
+		d[1] = (seconds % 60) / 10;
+		d[2] = MIN(seconds / 60, 99) % 10;
+		d[3] = MIN(seconds / 60, 99) / 10;
+	}
+	else
+	{
+		d[0] = value_ds % 10;
+		d[1] = seconds % 10;
+		d[2] = seconds / 10;
+		d[3] = LAYOUT_GLYPH_BLANK;
+	}
+
+	if(memcmp(clock_digits, d, sizeof(d)) != 0)
+	{
+		memcpy(clock_digits, d, sizeof(d));
+		dirty |= BIT(LAYOUT_CLOCK);
+	}
+}
+
+/* Moves every text longer than a widget showing it on by one character */
+static void update_text(void)
+{
+	uint32_t now_ms;
+
+	if(!LAYOUT_HAS_TEXT)
+	{
+		return;
+	}
+
+	now_ms = k_uptime_get_32();
+	if(now_ms - text_step_ms < CONFIG_SCOREBOARD_TEXT_SCROLL_MS)
+	{
+		return;
+	}
+	text_step_ms = now_ms;
+
+	for(uint8_t i = 0; i < LAYOUT_TEXT_COUNT; i++)
+	{
+		struct text *t = &texts[i];
+
+		if(t->len > t->cells)
+		{
+			t->offset = (t->offset + 1) % (t->len + TEXT_GAP);
+			dirty |= BIT(LAYOUT_TEXT);
+		}
+	}
+}
+
+void display_set_points(uint16_t home, uint16_t guest)
+{
+	if((points[0] != home) || (points[1] != guest))
+	{
+		points[0] = home;
+		points[1] = guest;
+		dirty |= BIT(LAYOUT_POINTS);
+	}
+}
+
+void display_set_sets(uint8_t home, uint8_t guest)
+{
+	home = MIN(home, 9);
+	guest = MIN(guest, 9);
+
+	if((sets[0] != home) || (sets[1] != guest))
+	{
+		sets[0] = home;
+		sets[1] = guest;
+		dirty |= BIT(LAYOUT_SETS);
+	}
+}
+
+void display_set_serving(uint8_t value)
+{
+	if(serving != value)
+	{
+		serving = value;
+		dirty |= BIT(LAYOUT_SERVING);
+	}
+}
+
+void display_set_text(enum layout_text text, const char *str)
+{
+	uint32_t glyphs[ARRAY_SIZE(texts[0].glyphs)] = { 0 };
+	struct text *t = &texts[text];
+	uint8_t len = MIN(strlen(str), TEXT_MAX_LEN);
+
+	if(!LAYOUT_HAS_TEXT)
+	{
+		return;
+	}
+
+	for(uint8_t i = 0; i < len; i++)
+	{
+		glyphs[i] = layout_font_glyph(str[i]);
+	}
+
+	/* The match record repeats, an unchanged text keeps scrolling */
+	if((t->len == len) && (memcmp(t->glyphs, glyphs, sizeof(glyphs)) == 0))
+	{
+		return;
+	}
+
+	memcpy(t->glyphs, glyphs, sizeof(glyphs));
+	t->len = len;
+	t->offset = 0;
+	dirty |= BIT(LAYOUT_TEXT);
+}
+
+void display_set_team_colors(struct led_rgb home, struct led_rgb guest)
+{
+	palette_dirty |= fb_palette_set(PAL_HOME, home);
+	palette_dirty |= fb_palette_set(PAL_GUEST, guest);
+}
+
+void display_set_brightness(uint8_t brightness)
+{
+	atomic_set(&brightness_req, brightness);
+}
+
+void display_frame_wait(void)
+{
+	uint32_t ticks = k_timer_status_sync(&frame_timer);
+	uint32_t now_cyc = k_cycle_get_32();
+	uint32_t interval_us = k_cyc_to_us_floor32(now_cyc - frame_start_cyc);
+	uint32_t jitter_us;
+
+	/* More than one expiry means whole frames were skipped */
+	if(ticks > 1)
+	{
+		sb_stat_add(&stats.deadline_misses, ticks - 1);
+	}
+
+	jitter_us = (interval_us > ticks * FRAME_PERIOD_US) ?
+		    interval_us - ticks * FRAME_PERIOD_US :
+		    ticks * FRAME_PERIOD_US - interval_us;
+	STATS_HIST(frame_jitter_us, jitter_us);
+
+	frame_start_cyc = now_cyc;
+	STATS_INC(frames);
+}
+
+void display_frame_commit_at(int64_t ticks)
+{
+	commit_at_ticks = ticks;
+}
+
+uint32_t display_commit_late_us(void)
+{
+	return commit_late_us;
+}
+
+/* Wait for the commit instant, returns the cycles spent waiting */
+static uint32_t commit_wait(void)
+{
+	uint32_t wait_start_cyc = k_cycle_get_32();
+
+	if(commit_at_ticks == 0)
+	{
+		return 0;
+	}
+
+	if(k_uptime_ticks() < commit_at_ticks)
+	{
+		k_sleep(K_TIMEOUT_ABS_TICKS(commit_at_ticks));
+	}
+
+	commit_late_us = k_ticks_to_us_floor32(k_uptime_ticks() - commit_at_ticks);
+	commit_at_ticks = 0;
+
+	return k_cycle_get_32() - wait_start_cyc;
+}
+
+void display_frame_render(void)
+{
+	uint32_t transfer_start_cyc;
+	uint32_t wait_cyc;
+	uint32_t render_us;
+
+	bool animating;
+	atomic_val_t brightness;
+
+	/* The color LUT is only rebuilt between commits */
+	brightness = atomic_set(&brightness_req, -1);
+	if(brightness >= 0)
+	{
+		color_set_brightness(brightness);
+		palette_dirty = true;
+	}
+
+	update_clock();
+	update_text();
+
+	/* Running transitions advance first, a dirty widget may preempt them */
+	animating = anim_step(&anims[LAYOUT_TEAM_HOME]);
+	animating |= anim_step(&anims[LAYOUT_TEAM_GUEST]);
+
+	if((dirty == 0) && !palette_dirty && !animating)
+	{
+		commit_at_ticks = 0;
+		return;
+	}
+
+	render_widgets(dirty);
+	dirty = 0;
+	palette_dirty = false;
+
+	/* The frame is staged in the framebuffer, only the commit waits */
+	wait_cyc = commit_wait();
+
+	transfer_start_cyc = k_cycle_get_32();
+	SB_TRACE_BEGIN(SB_TRACE_STRIP_UPDATE, FB_NUM_PIXELS);
+	fb_commit();
+	SB_TRACE_END(SB_TRACE_STRIP_UPDATE, FB_NUM_PIXELS);
+	STATS_HIST(strip_transfer_us, k_cyc_to_us_floor32(k_cycle_get_32() - transfer_start_cyc));
+	STATS_INC(renders);
+
+	render_us = k_cyc_to_us_floor32(k_cycle_get_32() - frame_start_cyc - wait_cyc);
+	STATS_HIST(render_us, render_us);
+	if(render_us > FRAME_PERIOD_US)
+	{
+		STATS_INC(deadline_misses);
+	}
+}
+
+int display_init(void)
+{
+	int err;
+
+	err = fb_init();
+	if (err) {
+		return err;
+	}
+
+	color_init();
+	fb_palette_set(PAL_HOME, RGB(0xFF, 0x00, 0x00));
+	fb_palette_set(PAL_GUEST, RGB(0xFF, 0x00, 0x00));
+	fb_palette_set(PAL_CLOCK, RGB(0xFF, 0x00, 0x00));
+	memset(clock_digits, LAYOUT_GLYPH_BLANK, sizeof(clock_digits));
+
+	for(uint8_t i = 0; i < LAYOUT_TEXT_COUNT; i++)
+	{
+		texts[i].cells = UINT8_MAX;
+	}
+
+	for(size_t i = 0; i < layout_num_widgets; i++)
+	{
+		const struct layout_widget *w = &layout_widgets[i];
+
+		if(w->type == LAYOUT_TEXT)
+		{
+			texts[w->text].cells = MIN(texts[w->text].cells, w->num_digits);
+		}
+	}
+	dirty = BIT(LAYOUT_POINTS) | BIT(LAYOUT_SERVING) | BIT(LAYOUT_SETS);
+
+	frame_start_cyc = k_cycle_get_32();
+	k_timer_start(&frame_timer, K_USEC(FRAME_PERIOD_US), K_USEC(FRAME_PERIOD_US));
+
+	return 0;
+}
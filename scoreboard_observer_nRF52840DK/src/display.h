@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include <stdint.h>
+#include <zephyr/drivers/led_strip.h>
+#include "layout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEAM_HOME_SERVING_BIT           1  // 1
+#define TEAM_GUEST_SERVING_BIT          2  // 2
+
+/* Time between two frame ticks */
+#define DISPLAY_FRAME_PERIOD_US         (USEC_PER_SEC / CONFIG_SCOREBOARD_FPS)
+
+/**
+ * @brief Initialize the LED strips and start the frame timer.
+ *
+ * @return 0 on success, -ENODEV if an LED strip is not ready.
+ */
+int display_init(void);
+
+/**
+ * @brief Set the points widget, rendered on the next frame.
+ *
+ * A widget shows the low digits of a value with more digits than it has.
+ */
+void display_set_points(uint16_t home, uint16_t guest);
+
+/** @brief Set the sets widget, rendered on the next frame. */
+void display_set_sets(uint8_t home, uint8_t guest);
+
+/** @brief Set the serving indicator, rendered on the next frame. */
+void display_set_serving(uint8_t serving);
+
+/**
+ * @brief Set the text of the text widgets showing @p text.
+ *
+ * The text is rasterized through the font here, once. Only a text longer
+ * than its widget scrolls, every CONFIG_SCOREBOARD_TEXT_SCROLL_MS.
+ */
+void display_set_text(enum layout_text text, const char *str);
+
+/**
+ * @brief Set the team colors.
+ *
+ * Only the palette changes, the next frame commits without redrawing any
+ * widget.
+ */
+void display_set_team_colors(struct led_rgb home, struct led_rgb guest);
+
+/**
+ * @brief Set the global brightness, applied through the color LUT at the
+ * next frame. May be called from any thread.
+ */
+void display_set_brightness(uint8_t brightness);
+
+/** @brief Block until the next frame tick. */
+void display_frame_wait(void);
+
+/**
+ * @brief Render the dirty widgets and commit them to the strip.
+ *
+ * Called once per frame tick, after the frame's widget updates.
+ */
+void display_frame_render(void);
+
+/**
+ * @brief Hold the strip update of the next rendered frame until @p ticks.
+ *
+ * The frame is rendered at its tick as usual and only the commit waits,
+ * so displays that hold until the same instant update together.
+ *
+ * @param ticks Uptime in ticks, at most one frame period ahead.
+ */
+void display_frame_commit_at(int64_t ticks);
+
+/**
+ * @brief How late the last held commit started, in microseconds.
+ */
+uint32_t display_commit_late_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISPLAY_H_ */
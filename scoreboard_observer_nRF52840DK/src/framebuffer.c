@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Palette-indexed framebuffer.
+ *
+ * The frame is kept as CONFIG_SCOREBOARD_FB_BPP bit palette indices, packed
+ * with the lowest pixel in the low bits of each byte. It is expanded to RGB
+ * only at commit time, into a wire buffer that the LED strip driver is free
+ * to overwrite. The color stage (color.c) corrects the palette, not the
+ * pixels, so the expansion stays the only pass over the frame.
+ *
+ * The chain may be split over several strips, each sent its slice of the
+ * wire buffer. led_strip_update_rgb() blocks until its transfer is done, so
+ * every strip after the first has a thread of its own. The commit releases
+ * them, sends the first strip itself and then waits for the others.
+ *
+ * WS2812 data shifts in from the head of the chain and every pixel keeps
+ * its color until new data reaches it, so a strip only needs the pixels up
+ * to its last change. The commit compares the frame and the corrected
+ * palette with the ones last sent and sends each strip that prefix. Widgets
+ * that change often are best placed at the head of the chain. How much
+ * transfer time that saves is up to the driver: one that always clocks out
+ * its whole transmit buffer, as ws2812-i2s may, only saves the expansion.
+ * The strip0_full_us and strip0_prefix_us histograms show which it is.
+ *
+ * RAM per LED is FB_BPP / 8 bytes for the frame, as much again for the frame
+ * last sent, and sizeof(struct led_rgb) for the wire buffer, which cannot go
+ * because led_strip_update_rgb() takes a whole strip of RGB pixels per
+ * transfer. That is more than the single RGB frame it replaced, the indices
+ * save the redraws on a palette change, not memory.
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+#include "color.h"
+#include "framebuffer.h"
+#include "stats.h"
+
+#define FB_INDEX_MASK (FB_PALETTE_SIZE - 1)
+
+/* GRB on the wire */
+#define FB_WIRE_BYTES_PER_PIXEL 3
+
+BUILD_ASSERT(FB_PALETTE_SIZE <= 16, "Changed palette entries are a 16 bit mask");
+
+/* Above the render thread, so that every transfer has started before it
+ * waits on its own
+ */
+#define FB_STRIP_STACKSIZE 1024
+#define FB_STRIP_PRIORITY  4
+
+struct fb_strip {
+	const struct device *dev;
+	uint16_t start;
+	uint16_t len;
+	/* Pixels to send at this commit, a prefix of len */
+	uint16_t count;
+	int err;
+};
+
+#if DT_NODE_HAS_PROP(LAYOUT_NODE, led_strips)
+#define FB_STRIP(_node, _prop, _idx)                                             \
+	{                                                                        \
+		.dev = DEVICE_DT_GET(DT_PHANDLE_BY_IDX(_node, _prop, _idx)),     \
+		.len = DT_PROP(DT_PHANDLE_BY_IDX(_node, _prop, _idx), chain_length), \
+	},
+
+static struct fb_strip strips[] = {
+	DT_FOREACH_PROP_ELEM(LAYOUT_NODE, led_strips, FB_STRIP)
+};
+#else
+static struct fb_strip strips[] = {
+	{ .dev = DEVICE_DT_GET(DT_ALIAS(led_strip)), .len = FB_NUM_PIXELS },
+};
+#endif
+
+BUILD_ASSERT(ARRAY_SIZE(strips) == FB_NUM_STRIPS);
+
+static uint8_t fb[FB_SIZE];
+static struct led_rgb palette[FB_PALETTE_SIZE];
+
+/* Pixels drawn with each palette entry, for the current estimate */
+static uint16_t counts[FB_PALETTE_SIZE];
+
+/* What the strips show, valid after a commit without errors */
+static uint8_t fb_sent[FB_SIZE];
+static struct led_rgb palette_sent[FB_PALETTE_SIZE];
+static bool sent_valid;
+
+/* Scratch for led_strip_update_rgb(), which may modify the pixels it is
+ * given. Nothing is kept here between commits.
+ */
+static struct led_rgb wire[FB_NUM_PIXELS];
+
+static void strip_send(struct fb_strip *strip)
+{
+	strip->err = 0;
+	if(strip->count > 0)
+	{
+		strip->err = led_strip_update_rgb(strip->dev, &wire[strip->start], strip->count);
+	}
+}
+
+#if FB_NUM_STRIPS > 1
+static K_THREAD_STACK_ARRAY_DEFINE(strip_stacks, FB_NUM_STRIPS - 1, FB_STRIP_STACKSIZE);
+static struct k_thread strip_threads[FB_NUM_STRIPS - 1];
+static struct k_sem strip_go[FB_NUM_STRIPS - 1];
+static K_SEM_DEFINE(strip_done, 0, FB_NUM_STRIPS - 1);
+
+static void strip_thread(void *p1, void *p2, void *p3)
+{
+	struct fb_strip *strip = p1;
+	struct k_sem *go = p2;
+
+	ARG_UNUSED(p3);
+
+	for(;;)
+	{
+		k_sem_take(go, K_FOREVER);
+		strip_send(strip);
+		k_sem_give(&strip_done);
+	}
+}
+
+static void strip_threads_start(void)
+{
+	for(uint8_t i = 1; i < FB_NUM_STRIPS; i++)
+	{
+		k_sem_init(&strip_go[i - 1], 0, 1);
+		k_thread_create(&strip_threads[i - 1], strip_stacks[i - 1],
+				K_THREAD_STACK_SIZEOF(strip_stacks[i - 1]), strip_thread,
+				&strips[i], &strip_go[i - 1], NULL,
+				FB_STRIP_PRIORITY, 0, K_NO_WAIT);
+	}
+}
+#endif /* FB_NUM_STRIPS > 1 */
+
+int fb_init(void)
+{
+	uint16_t start = 0;
+
+	for(uint8_t i = 0; i < FB_NUM_STRIPS; i++)
+	{
+		if (!device_is_ready(strips[i].dev)) {
+			return -ENODEV;
+		}
+
+		strips[i].start = start;
+		start += strips[i].len;
+	}
+
+	memset(fb, 0x00, sizeof(fb));
+	memset(palette, 0x00, sizeof(palette));
+	memset(counts, 0x00, sizeof(counts));
+	counts[FB_INDEX_OFF] = FB_NUM_PIXELS;
+	sent_valid = false;
+
+#if FB_NUM_STRIPS > 1
+	strip_threads_start();
+#endif
+
+	return 0;
+}
+
+/* Fields only, struct led_rgb may carry a scratch byte */
+static inline bool rgb_equal(struct led_rgb a, struct led_rgb b)
+{
+	return (a.r == b.r) && (a.g == b.g) && (a.b == b.b);
+}
+
+static inline uint8_t index_get(const uint8_t *buf, uint16_t pixel)
+{
+	uint8_t shift = (pixel % FB_PIXELS_PER_BYTE) * FB_BPP;
+
+	return (buf[pixel / FB_PIXELS_PER_BYTE] >> shift) & FB_INDEX_MASK;
+}
+
+void fb_set(uint16_t pixel, uint8_t index)
+{
+	uint8_t shift = (pixel % FB_PIXELS_PER_BYTE) * FB_BPP;
+	uint8_t *byte = &fb[pixel / FB_PIXELS_PER_BYTE];
+
+	__ASSERT_NO_MSG(pixel < FB_NUM_PIXELS);
+
+	index &= FB_INDEX_MASK;
+	counts[(*byte >> shift) & FB_INDEX_MASK]--;
+	counts[index]++;
+
+	*byte = (*byte & ~(FB_INDEX_MASK << shift)) | (index << shift);
+}
+
+uint8_t fb_get(uint16_t pixel)
+{
+	__ASSERT_NO_MSG(pixel < FB_NUM_PIXELS);
+
+	return index_get(fb, pixel);
+}
+
+void fb_fill(uint16_t start, uint16_t count, uint8_t index)
+{
+	for(uint16_t i = start; i < start + count; i++)
+	{
+		fb_set(i, index);
+	}
+}
+
+bool fb_palette_set(uint8_t index, struct led_rgb color)
+{
+	struct led_rgb *entry = &palette[index & FB_INDEX_MASK];
+
+	if(rgb_equal(*entry, color))
+	{
+		return false;
+	}
+
+	*entry = color;
+
+	return true;
+}
+
+struct led_rgb fb_palette_get(uint8_t index)
+{
+	return palette[index & FB_INDEX_MASK];
+}
+
+/* Expand @p count pixels from @p first, one load per packed byte and one
+ * palette lookup per pixel
+ */
+static void expand(const struct led_rgb *corrected, uint16_t first, uint16_t count,
+		   struct led_rgb *out)
+{
+	uint16_t pixel = first;
+	uint16_t end = first + count;
+
+	while(pixel < end)
+	{
+		uint8_t j = pixel % FB_PIXELS_PER_BYTE;
+		uint8_t byte = fb[pixel / FB_PIXELS_PER_BYTE] >> (j * FB_BPP);
+
+		for(; (j < FB_PIXELS_PER_BYTE) && (pixel < end); j++)
+		{
+			*out++ = corrected[byte & FB_INDEX_MASK];
+			byte >>= FB_BPP;
+			pixel++;
+		}
+	}
+}
+
+void fb_expand(struct led_rgb *out, uint32_t *current_ma)
+{
+	struct led_rgb corrected[FB_PALETTE_SIZE];
+
+	*current_ma = color_apply(palette, counts, corrected, FB_PALETTE_SIZE);
+	expand(corrected, 0, FB_NUM_PIXELS, out);
+}
+
+/* Length of the prefix of a strip that ends with its last pixel that
+ * changed index, or is drawn with a palette entry in @p changed
+ */
+static uint16_t strip_changed(const struct fb_strip *strip, uint16_t changed)
+{
+	for(uint16_t pixel = strip->start + strip->len; pixel > strip->start; pixel--)
+	{
+		uint8_t index = index_get(fb, pixel - 1);
+
+		if((index != index_get(fb_sent, pixel - 1)) || (changed & BIT(index)))
+		{
+			return pixel - strip->start;
+		}
+	}
+
+	return 0;
+}
+
+int fb_commit(void)
+{
+	struct led_rgb corrected[FB_PALETTE_SIZE];
+	uint32_t current_ma;
+	uint32_t pixels = 0;
+	uint32_t send_start_cyc;
+	uint32_t send_us;
+	uint16_t changed = 0;
+	int err = 0;
+
+	current_ma = color_apply(palette, counts, corrected, FB_PALETTE_SIZE);
+	STATS_HIST(frame_demand_ma, current_ma);
+	if(COLOR_LIMITED(current_ma))
+	{
+		STATS_INC(current_limits);
+	}
+
+	for(uint8_t i = 0; i < FB_PALETTE_SIZE; i++)
+	{
+		if(!rgb_equal(corrected[i], palette_sent[i]))
+		{
+			changed |= BIT(i);
+		}
+	}
+
+	for(uint8_t i = 0; i < FB_NUM_STRIPS; i++)
+	{
+		struct fb_strip *strip = &strips[i];
+
+		strip->count = sent_valid ? strip_changed(strip, changed) : strip->len;
+		expand(corrected, strip->start, strip->count, &wire[strip->start]);
+		pixels += strip->count;
+	}
+
+#if FB_NUM_STRIPS > 1
+	for(uint8_t i = 1; i < FB_NUM_STRIPS; i++)
+	{
+		k_sem_give(&strip_go[i - 1]);
+	}
+#endif
+
+	send_start_cyc = k_cycle_get_32();
+	strip_send(&strips[0]);
+	send_us = k_cyc_to_us_floor32(k_cycle_get_32() - send_start_cyc);
+
+	if(strips[0].count == strips[0].len)
+	{
+		STATS_HIST(strip0_full_us, send_us);
+	}
+	else if(strips[0].count > 0)
+	{
+		STATS_HIST(strip0_prefix_us, send_us);
+	}
+
+#if FB_NUM_STRIPS > 1
+	for(uint8_t i = 1; i < FB_NUM_STRIPS; i++)
+	{
+		k_sem_take(&strip_done, K_FOREVER);
+	}
+#endif
+
+	for(uint8_t i = 0; (i < FB_NUM_STRIPS) && (err == 0); i++)
+	{
+		err = strips[i].err;
+	}
+
+	STATS_HIST(update_bytes, pixels * FB_WIRE_BYTES_PER_PIXEL);
+
+	/* After a failed transfer the strips are in an unknown state */
+	sent_valid = (err == 0);
+	if(sent_valid)
+	{
+		memcpy(fb_sent, fb, sizeof(fb_sent));
+		memcpy(palette_sent, corrected, sizeof(palette_sent));
+	}
+
+	return err;
+}
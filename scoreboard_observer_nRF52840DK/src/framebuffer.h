@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef FRAMEBUFFER_H_
+#define FRAMEBUFFER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/led_strip.h>
+#include <zephyr/sys/util.h>
+#include "layout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pixels on strip _idx of the layout's led-strips */
+#define FB_STRIP_PIXELS(_idx, _) \
+	DT_PROP(DT_PHANDLE_BY_IDX(LAYOUT_NODE, led_strips, _idx), chain_length)
+
+/* The chain is the layout's led-strips one after the other, or the led-strip
+ * alias. LISTIFY rather than DT_FOREACH_PROP_ELEM, which cannot nest in the
+ * layout checks.
+ */
+#if DT_NODE_HAS_PROP(LAYOUT_NODE, led_strips)
+#define FB_NUM_STRIPS      DT_PROP_LEN(LAYOUT_NODE, led_strips)
+#define FB_NUM_PIXELS      (LISTIFY(FB_NUM_STRIPS, FB_STRIP_PIXELS, (+)))
+#else
+#define FB_NUM_STRIPS      1
+#define FB_NUM_PIXELS      DT_PROP(DT_ALIAS(led_strip), chain_length)
+#endif
+
+#define FB_BPP             CONFIG_SCOREBOARD_FB_BPP
+#define FB_PALETTE_SIZE    BIT(FB_BPP)
+#define FB_PIXELS_PER_BYTE (8 / FB_BPP)
+#define FB_SIZE            DIV_ROUND_UP(FB_NUM_PIXELS, FB_PIXELS_PER_BYTE)
+
+/* The cleared frame, palette entry 0 is kept black */
+#define FB_INDEX_OFF       0
+
+/**
+ * @brief Clear the framebuffer to palette index 0 and the palette to black,
+ * and start the transfer threads of the strips after the first.
+ *
+ * @return 0 on success, -ENODEV if an LED strip is not ready.
+ */
+int fb_init(void);
+
+/** @brief Set a pixel to a palette index. */
+void fb_set(uint16_t pixel, uint8_t index);
+
+/** @brief Palette index of a pixel. */
+uint8_t fb_get(uint16_t pixel);
+
+/** @brief Set @p count pixels from @p start to a palette index. */
+void fb_fill(uint16_t start, uint16_t count, uint8_t index);
+
+/**
+ * @brief Change a palette entry.
+ *
+ * Every pixel drawn with @p index takes the new color at the next commit,
+ * nothing has to be redrawn.
+ *
+ * @return true if the entry changed.
+ */
+bool fb_palette_set(uint8_t index, struct led_rgb color);
+
+/** @brief Palette entry as drawn, before color correction. */
+struct led_rgb fb_palette_get(uint8_t index);
+
+/**
+ * @brief Expand the framebuffer through the color corrected palette.
+ *
+ * Used by fb_commit(), exposed for the benchmark.
+ *
+ * @param out FB_NUM_PIXELS pixels.
+ * @param current_ma Estimated frame current in mA before limiting.
+ */
+void fb_expand(struct led_rgb *out, uint32_t *current_ma);
+
+/**
+ * @brief Expand the framebuffer through the color corrected palette and
+ * send it to the strips.
+ *
+ * The strips transfer concurrently, the call returns when all are done.
+ *
+ * @return 0 on success, the first negative errno from led_strip_update_rgb().
+ */
+int fb_commit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAMEBUFFER_H_ */
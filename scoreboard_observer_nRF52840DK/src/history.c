@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Score history.
+ *
+ * Every score report carries the score, its sequence and the last
+ * SB_SCORE_HISTORY_LEN changes. The score alone brings a late joiner or an
+ * observer that missed reports up to date. The sequence tells how many
+ * changes were missed, and the history gives back the scores in between as
+ * long as the gap fits in it, for example the points of a fast burst of
+ * commands that all went out between two reports the observer caught.
+ *
+ * With CONFIG_SCOREBOARD_SIM_LOSS_PCT main.c drops reports at random. The
+ * time from the first dropped report of a newer score until a report
+ * brings the observer to that score is the convergence time.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <scoreboard_proto.h>
+#include <sb_history.h>
+#include "history.h"
+#include "stats.h"
+
+LOG_MODULE_DECLARE(observer, LOG_LEVEL_INF);
+
+/* Newest epoch and sequence received, BT RX thread only */
+static uint16_t last_seq;
+static uint8_t last_epoch;
+static bool last_valid;
+
+/* First dropped report of a sequence not received yet */
+static uint16_t lost_seq;
+static int64_t lost_ms;
+static bool lost_pending;
+
+void history_score_received(const uint8_t *data, uint8_t len)
+{
+	const struct sb_score_adv *rx = (const struct sb_score_adv *)data;
+	struct sb_score scores[SB_SCORE_HISTORY_LEN];
+	struct sb_score score;
+	uint16_t seq, gap, missed;
+	uint16_t recovered = 0;
+
+	if (len < sizeof(*rx)) {
+		return;
+	}
+
+	seq = sys_le16_to_cpu(rx->seq);
+	gap = seq - last_seq;
+
+	/* After a broadcaster restart the sequences start over, nothing
+	 * before the first report of the new epoch can be recovered
+	 */
+	if (last_valid && (rx->epoch != last_epoch)) {
+		last_valid = false;
+		lost_pending = false;
+	}
+
+	if (lost_pending && ((int16_t)(seq - lost_seq) >= 0)) {
+		lost_pending = false;
+		STATS_HIST(converge_ms, (uint32_t)(k_uptime_get() - lost_ms));
+	}
+
+	/* A late joiner is up to date with the first report */
+	if (!last_valid) {
+		last_seq = seq;
+		last_epoch = rx->epoch;
+		last_valid = true;
+		return;
+	}
+
+	/* A repeat, or an older score the broadcaster sent itself */
+	if ((gap == 0) || ((int16_t)gap < 0)) {
+		last_seq = seq;
+		return;
+	}
+
+	last_seq = seq;
+	if (gap == 1) {
+		return;
+	}
+
+	missed = gap - 1;
+	STATS_INC(score_gaps);
+
+	/* Walk back from the received score, scores[i] is seq - i - 1 */
+	score = rx->score;
+	while ((recovered < MIN(missed, SB_SCORE_HISTORY_LEN)) &&
+	       sb_history_undo(&score, rx->history[recovered])) {
+		scores[recovered++] = score;
+	}
+
+	sb_stat_add(&stats.gap_scores_recovered, recovered);
+	sb_stat_add(&stats.gap_scores_lost, missed - recovered);
+
+	if (IS_ENABLED(CONFIG_SCOREBOARD_LOG_UPDATES)) {
+		for (int i = recovered - 1; i >= 0; i--) {
+			LOG_INF("Recovered score %u: %u-%u, sets %u-%u", (uint16_t)(seq - i - 1),
+				sys_le16_to_cpu(scores[i].home_points),
+				sys_le16_to_cpu(scores[i].guest_points), scores[i].home_sets,
+				scores[i].guest_sets);
+		}
+
+		if (recovered < missed) {
+			LOG_INF("Missed %u scores before %u", missed - recovered,
+				(uint16_t)(seq - recovered));
+		}
+	}
+}
+
+void history_score_lost(const uint8_t *data, uint8_t len)
+{
+	const struct sb_score_adv *rx = (const struct sb_score_adv *)data;
+	uint16_t seq;
+
+	if (len < sizeof(*rx)) {
+		return;
+	}
+
+	seq = sys_le16_to_cpu(rx->seq);
+
+	if (lost_pending ||
+	    (last_valid && (rx->epoch == last_epoch) && ((int16_t)(seq - last_seq) <= 0))) {
+		return;
+	}
+
+	lost_seq = seq;
+	lost_ms = k_uptime_get();
+	lost_pending = true;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Check an accepted score report for missed score changes.
+ *
+ * Missed changes are recovered from the history of the report as far as it
+ * reaches. Called from the Bluetooth RX thread.
+ *
+ * @param data Manufacturer data, struct sb_score_adv.
+ * @param len Length of @p data.
+ */
+void history_score_received(const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Note a score report dropped by CONFIG_SCOREBOARD_SIM_LOSS_PCT.
+ *
+ * The time until a later report brings the observer up to its sequence is
+ * recorded as the convergence time. Called from the Bluetooth RX thread.
+ *
+ * @param data Manufacturer data, struct sb_score_adv.
+ * @param len Length of @p data.
+ */
+void history_score_lost(const uint8_t *data, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HISTORY_H_ */
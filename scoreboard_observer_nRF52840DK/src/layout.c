@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Widget and glyph tables, generated from the devicetree at compile time.
+ *
+ * The glyphs and the font are written as seven segment masks and expanded
+ * to pixel masks through the layout's segment-map and leds-per-segment by
+ * the preprocessor, so nothing is computed at runtime.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/util.h>
+#include <scoreboard-layout-bindings.h>
+#include "framebuffer.h"
+#include "layout.h"
+
+BUILD_ASSERT(DT_NODE_EXISTS(LAYOUT_NODE), "No scoreboard,display-layout node");
+BUILD_ASSERT(DT_PROP_LEN(LAYOUT_NODE, segment_map) == 7, "segment-map needs 7 entries");
+BUILD_ASSERT((LAYOUT_LEDS_PER_SEGMENT >= 1) && (LAYOUT_LEDS_PER_SEGMENT <= 4),
+	     "leds-per-segment must be 1 to 4");
+
+#define SEG(_s) BIT(SEG_##_s)
+
+/* Pixels of chain position _pos in a digit if _seg7 lights its segment */
+#define GLYPH_POS(_seg7, _pos)                                                   \
+	((((_seg7) >> DT_PROP_BY_IDX(LAYOUT_NODE, segment_map, _pos)) & 1) *     \
+	 (BIT_MASK(LAYOUT_LEDS_PER_SEGMENT) << ((_pos) * LAYOUT_LEDS_PER_SEGMENT)))
+
+#define GLYPH(_seg7)                                                             \
+	(GLYPH_POS(_seg7, 0) | GLYPH_POS(_seg7, 1) | GLYPH_POS(_seg7, 2) |      \
+	 GLYPH_POS(_seg7, 3) | GLYPH_POS(_seg7, 4) | GLYPH_POS(_seg7, 5) |      \
+	 GLYPH_POS(_seg7, 6))
+
+#define SEG7_0 (SEG(A) | SEG(B) | SEG(C) | SEG(D) | SEG(E) | SEG(F))
+#define SEG7_1 (SEG(B) | SEG(C))
+#define SEG7_2 (SEG(A) | SEG(B) | SEG(D) | SEG(E) | SEG(G))
+#define SEG7_3 (SEG(A) | SEG(B) | SEG(C) | SEG(D) | SEG(G))
+#define SEG7_4 (SEG(B) | SEG(C) | SEG(F) | SEG(G))
+#define SEG7_5 (SEG(A) | SEG(C) | SEG(D) | SEG(F) | SEG(G))
+#define SEG7_6 (SEG(A) | SEG(C) | SEG(D) | SEG(E) | SEG(F) | SEG(G))
+#define SEG7_7 (SEG(A) | SEG(B) | SEG(C))
+#define SEG7_8 (SEG(A) | SEG(B) | SEG(C) | SEG(D) | SEG(E) | SEG(F) | SEG(G))
+#define SEG7_9 (SEG(A) | SEG(B) | SEG(C) | SEG(F) | SEG(G))
+
+const uint32_t layout_glyphs[] = {
+	GLYPH(SEG7_0), GLYPH(SEG7_1), GLYPH(SEG7_2), GLYPH(SEG7_3), GLYPH(SEG7_4),
+	GLYPH(SEG7_5), GLYPH(SEG7_6), GLYPH(SEG7_7), GLYPH(SEG7_8), GLYPH(SEG7_9),
+	GLYPH(0), /* blank */
+};
+
+BUILD_ASSERT(ARRAY_SIZE(layout_glyphs) == LAYOUT_GLYPH_BLANK + 1);
+
+#define FONT(_c, _seg7) [(_c) - LAYOUT_FONT_FIRST] = GLYPH(_seg7)
+
+/* Characters without a readable seven segment form stay blank. Some letters
+ * share a form (U and V, H and X), M and W are approximations.
+ */
+const uint32_t layout_font[LAYOUT_FONT_SIZE] = {
+	FONT('"', SEG(B) | SEG(F)),
+	FONT('\'', SEG(B)),
+	FONT('(', SEG(A) | SEG(D) | SEG(E) | SEG(F)),
+	FONT(')', SEG(A) | SEG(B) | SEG(C) | SEG(D)),
+	FONT('-', SEG(G)),
+	FONT('/', SEG(B) | SEG(E) | SEG(G)),
+	FONT('0', SEG7_0),
+	FONT('1', SEG7_1),
+	FONT('2', SEG7_2),
+	FONT('3', SEG7_3),
+	FONT('4', SEG7_4),
+	FONT('5', SEG7_5),
+	FONT('6', SEG7_6),
+	FONT('7', SEG7_7),
+	FONT('8', SEG7_8),
+	FONT('9', SEG7_9),
+	FONT('=', SEG(D) | SEG(G)),
+	FONT('?', SEG(A) | SEG(B) | SEG(E) | SEG(G)),
+	FONT('A', SEG(A) | SEG(B) | SEG(C) | SEG(E) | SEG(F) | SEG(G)),
+	FONT('B', SEG(C) | SEG(D) | SEG(E) | SEG(F) | SEG(G)),
+	FONT('C', SEG(A) | SEG(D) | SEG(E) | SEG(F)),
+	FONT('D', SEG(B) | SEG(C) | SEG(D) | SEG(E) | SEG(G)),
+	FONT('E', SEG(A) | SEG(D) | SEG(E) | SEG(F) | SEG(G)),
+	FONT('F', SEG(A) | SEG(E) | SEG(F) | SEG(G)),
+	FONT('G', SEG(A) | SEG(C) | SEG(D) | SEG(E) | SEG(F)),
+	FONT('H', SEG(B) | SEG(C) | SEG(E) | SEG(F) | SEG(G)),
+	FONT('I', SEG(E) | SEG(F)),
+	FONT('J', SEG(B) | SEG(C) | SEG(D) | SEG(E)),
+	FONT('K', SEG(A) | SEG(C) | SEG(E) | SEG(F) | SEG(G)),
+	FONT('L', SEG(D) | SEG(E) | SEG(F)),
+	FONT('M', SEG(A) | SEG(C) | SEG(E)),
+	FONT('N', SEG(A) | SEG(B) | SEG(C) | SEG(E) | SEG(F)),
+	FONT('O', SEG7_0),
+	FONT('P', SEG(A) | SEG(B) | SEG(E) | SEG(F) | SEG(G)),
+	FONT('Q', SEG(A) | SEG(B) | SEG(D) | SEG(F) | SEG(G)),
+	FONT('R', SEG(A) | SEG(B) | SEG(E) | SEG(F)),
+	FONT('S', SEG7_5),
+	FONT('T', SEG(D) | SEG(E) | SEG(F) | SEG(G)),
+	FONT('U', SEG(B) | SEG(C) | SEG(D) | SEG(E) | SEG(F)),
+	FONT('V', SEG(B) | SEG(C) | SEG(D) | SEG(E) | SEG(F)),
+	FONT('W', SEG(B) | SEG(D) | SEG(F)),
+	FONT('X', SEG(B) | SEG(C) | SEG(E) | SEG(F) | SEG(G)),
+	FONT('Y', SEG(B) | SEG(C) | SEG(D) | SEG(F) | SEG(G)),
+	FONT('Z', SEG7_2),
+	FONT('[', SEG(A) | SEG(D) | SEG(E) | SEG(F)),
+	FONT('\\', SEG(C) | SEG(F) | SEG(G)),
+	FONT(']', SEG(A) | SEG(B) | SEG(C) | SEG(D)),
+	FONT('^', SEG(A) | SEG(B) | SEG(F)),
+	FONT('_', SEG(D)),
+};
+
+uint32_t layout_font_glyph(char c)
+{
+	if((c >= 'a') && (c <= 'z'))
+	{
+		c -= 'a' - 'A';
+	}
+
+	if((c < LAYOUT_FONT_FIRST) || (c > LAYOUT_FONT_LAST))
+	{
+		return 0;
+	}
+
+	return layout_font[c - LAYOUT_FONT_FIRST];
+}
+
+/* Everything has to fit on the chain */
+#define CHECK_DIGIT(_node, _prop, _idx)                                          \
+	BUILD_ASSERT(DT_PROP_BY_IDX(_node, _prop, _idx) + LAYOUT_LEDS_PER_DIGIT  \
+		     <= FB_NUM_PIXELS, "Digit past the end of the chain");
+
+#define CHECK_WIDGET(_node)                                                      \
+	IF_ENABLED(DT_NODE_HAS_PROP(_node, digit_offsets),                       \
+		   (DT_FOREACH_PROP_ELEM(_node, digit_offsets, CHECK_DIGIT)))    \
+	IF_ENABLED(DT_NODE_HAS_PROP(_node, pixels),                              \
+		   (BUILD_ASSERT(DT_PROP_BY_IDX(_node, pixels, 0) +              \
+				 DT_PROP_BY_IDX(_node, pixels, 1) <= FB_NUM_PIXELS, \
+				 "Indicator past the end of the chain");))
+
+DT_FOREACH_CHILD_STATUS_OKAY(LAYOUT_NODE, CHECK_WIDGET)
+
+#define WIDGET_DIGITS(_node)                                                     \
+	IF_ENABLED(DT_NODE_HAS_PROP(_node, digit_offsets),                       \
+		   (static const uint16_t DT_CAT(digits_, _node)[] =             \
+			DT_PROP(_node, digit_offsets);))
+
+DT_FOREACH_CHILD_STATUS_OKAY(LAYOUT_NODE, WIDGET_DIGITS)
+
+#define WIDGET(_node)                                                            \
+	{                                                                        \
+		.digits = COND_CODE_1(DT_NODE_HAS_PROP(_node, digit_offsets),    \
+				      (DT_CAT(digits_, _node)), (NULL)),          \
+		.num_digits = DT_PROP_LEN_OR(_node, digit_offsets, 0),           \
+		.type = DT_ENUM_IDX(_node, widget),                              \
+		.team = DT_ENUM_IDX_OR(_node, team, LAYOUT_TEAM_HOME),           \
+		.text = DT_ENUM_IDX_OR(_node, text, LAYOUT_TEXT_HOME_NAME),      \
+		.blank_zeros = DT_PROP(_node, blank_leading_zeros),              \
+		.start = COND_CODE_1(DT_NODE_HAS_PROP(_node, pixels),            \
+				     (DT_PROP_BY_IDX(_node, pixels, 0)), (0)),    \
+		.len = COND_CODE_1(DT_NODE_HAS_PROP(_node, pixels),              \
+				   (DT_PROP_BY_IDX(_node, pixels, 1)), (0)),      \
+	},
+
+const struct layout_widget layout_widgets[] = {
+	DT_FOREACH_CHILD_STATUS_OKAY(LAYOUT_NODE, WIDGET)
+};
+
+const size_t layout_num_widgets = ARRAY_SIZE(layout_widgets);
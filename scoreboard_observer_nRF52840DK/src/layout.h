@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LAYOUT_H_
+#define LAYOUT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/devicetree.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Display geometry from the scoreboard,display-layout devicetree node */
+#define LAYOUT_NODE             DT_COMPAT_GET_ANY_STATUS_OKAY(scoreboard_display_layout)
+#define LAYOUT_LEDS_PER_SEGMENT DT_PROP(LAYOUT_NODE, leds_per_segment)
+#define LAYOUT_LEDS_PER_DIGIT   (7 * LAYOUT_LEDS_PER_SEGMENT)
+
+/* Index of the blank glyph in layout_glyphs */
+#define LAYOUT_GLYPH_BLANK      10
+
+/* Characters in layout_font, lower case letters are drawn as upper case */
+#define LAYOUT_FONT_FIRST       ' '
+#define LAYOUT_FONT_LAST        '_'
+#define LAYOUT_FONT_SIZE        (LAYOUT_FONT_LAST - LAYOUT_FONT_FIRST + 1)
+
+/* In the order of the binding's widget enum */
+enum layout_widget_type {
+	LAYOUT_POINTS,
+	LAYOUT_SETS,
+	LAYOUT_SERVING,
+	LAYOUT_CLOCK,
+	LAYOUT_TEXT,
+};
+
+/* In the order of the binding's team enum */
+enum layout_team {
+	LAYOUT_TEAM_HOME,
+	LAYOUT_TEAM_GUEST,
+};
+
+/* In the order of the binding's text enum */
+enum layout_text {
+	LAYOUT_TEXT_HOME_NAME,
+	LAYOUT_TEXT_GUEST_NAME,
+	LAYOUT_TEXT_MESSAGE,
+	LAYOUT_TEXT_COUNT,
+};
+
+struct layout_widget {
+	/* First pixel of each digit, least significant first. Text widgets
+	 * list their character cells left to right.
+	 */
+	const uint16_t *digits;
+	uint8_t num_digits;
+	uint8_t type;
+	uint8_t team;
+	uint8_t text;
+	bool blank_zeros;
+	/* Indicator pixels */
+	uint16_t start;
+	uint16_t len;
+};
+
+#define LAYOUT_IS_CLOCK(_node) + (DT_ENUM_IDX(_node, widget) == LAYOUT_CLOCK)
+
+/* True if the layout has a clock widget */
+#define LAYOUT_HAS_CLOCK (0 DT_FOREACH_CHILD_STATUS_OKAY(LAYOUT_NODE, LAYOUT_IS_CLOCK))
+
+#define LAYOUT_IS_TEXT(_node) + (DT_ENUM_IDX(_node, widget) == LAYOUT_TEXT)
+
+/* True if the layout has a text widget */
+#define LAYOUT_HAS_TEXT (0 DT_FOREACH_CHILD_STATUS_OKAY(LAYOUT_NODE, LAYOUT_IS_TEXT))
+
+extern const struct layout_widget layout_widgets[];
+extern const size_t layout_num_widgets;
+
+/* Lit pixels of each glyph, bit 0 is the first pixel of the digit */
+extern const uint32_t layout_glyphs[];
+
+/* Lit pixels of each character from LAYOUT_FONT_FIRST, as layout_glyphs */
+extern const uint32_t layout_font[];
+
+/**
+ * @brief Lit pixels of a character.
+ *
+ * @return The glyph from layout_font, blank for characters it has no glyph
+ * for, including every byte of a multibyte UTF-8 sequence.
+ */
+uint32_t layout_font_glyph(char c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LAYOUT_H_ */
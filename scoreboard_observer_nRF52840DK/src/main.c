@@ -5,200 +5,223 @@
  */
 
 #include <zephyr/kernel.h>
-#include <zephyr/sys/printk.h>
+#include <zephyr/logging/log.h>
 #include <zephyr/bluetooth/bluetooth.h>
 #include <dk_buttons_and_leds.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
-#include <zephyr/drivers/led_strip.h>
 #include <zephyr/device.h>
-#include <zephyr/drivers/i2s.h>
+#include <zephyr/random/rand32.h>
+#include <zephyr/sys/byteorder.h>
 #include <zephyr/sys/util.h>
+#include <zephyr/zbus/zbus.h>
+#include <scoreboard_proto.h>
+#include <sb_chan.h>
+#include <sb_trace.h>
+#include "central.h"
+#include "channels.h"
+#include "clock.h"
+#include "display.h"
+#include "history.h"
+#include "match.h"
+#include "pawr.h"
+#include "phy.h"
+#include "relay.h"
+#include "stats.h"
 
 /* RTOS Task properties */
 #define SB_STACKSIZE       1024
 #define SB_PRIORITY        5 
 
-#define TEAM_HOME_SERVING_BIT           1  // 1
-#define TEAM_GUEST_SERVING_BIT          2  // 2
-
 #define NAME_LEN 30
-#define MAN_LEN  8
+#define MAN_LEN  sizeof(struct sb_score)
 #define BT_DEVICE "Score Board"
 
-#define STRIP_NODE		DT_ALIAS(led_strip)
-#define STRIP_NUM_PIXELS	DT_PROP(DT_ALIAS(led_strip), chain_length)
+/* Keep the repeats of unchanged advertising data */
+#define SCAN_ALL_REPORTS (IS_ENABLED(CONFIG_SCOREBOARD_PHY_PER) || \
+			  (CONFIG_SCOREBOARD_SIM_LOSS_PCT > 0))
 
-#define RGB_LEDS_PER_DIGIT 14
+LOG_MODULE_REGISTER(observer, LOG_LEVEL_INF);
 
-#define RGB(_r, _g, _b) { .r = (_r), .g = (_g), .b = (_b) }
+char bt_device_name[NAME_LEN] = {0,};
 
-static const struct led_rgb colors[] = {
-	RGB(0xFF, 0x00, 0x00), /* red */
-	RGB(0x00, 0xFF, 0x00), /* green */
-	RGB(0x00, 0x00, 0xFF), /* blue */
+/* One scan report being parsed, the name comes before the manufacturer data */
+struct scan_report {
+	const struct bt_le_scan_recv_info *info;
+	bool name_found;
 };
 
-static const struct led_rgb black = {
-	.r = 0x00,
-	.g = 0x00,
-	.b = 0x00,
-};
+/* Report dropped by CONFIG_SCOREBOARD_SIM_LOSS_PCT, BT RX thread only */
+static bool sim_lost;
 
-struct led_rgb pixels[STRIP_NUM_PIXELS];
+/* A full subscriber queue drops the notification rather than stalling the
+ * BT RX thread, subscribers read the newest score anyway
+ */
+#define SCORE_NOTIFY_TIMEOUT K_MSEC(1)
 
-static const struct device *const strip = DEVICE_DT_GET(STRIP_NODE);
+/* While synced to PAwR, a score from another path waits this long for its
+ * PAwR apply time before it is shown anyway
+ */
+#define SCORE_HOLD_MS 1000
 
-/* Define semaphore */
-K_SEM_DEFINE(sem, 0, 1);
+enum score_path {
+	SCORE_ADV,
+	SCORE_GATT,
+	SCORE_PAWR,
+};
 
-char bt_device_name[NAME_LEN] = {0,};
-bool bt_device_found = false;
-uint8_t bt_man_data[MAN_LEN] = {0,};
-uint8_t bt_man_data_curr[MAN_LEN] = {0,};
-
-long numbers[] = {
-  0b00111111111111,  // [0] 0
-  0b00110000000011,  // [1] 1
-  0b11111100111100,  // [2] 2
-  0b11111100001111,  // [3] 3
-  0b11110011000011,  // [4] 4
-  0b11001111001111,  // [5] 5
-  0b11001111111111,  // [6] 6
-  0b00111100000011,  // [7] 7
-  0b11111111111111,  // [8] 8
-  0b11111111000011,  // [9] 9
- };
-
-
-void update_points(uint8_t homepoints, uint8_t guestpoints)
+/* Arrival of the last new score, to time one path against the other.
+ * Written by the BT RX thread with score_chan claimed.
+ */
+static int64_t score_rx_ms;
+static bool score_rx_gatt;
+static bool score_rx_open;
+
+/* Apply time of a score that did not come over PAwR */
+static int64_t hold_ticks(void)
 {
-	uint8_t guest_digit_zero_index = 0;
-	uint8_t guest_digit_one_index = 14;
-	uint8_t home_digit_zero_index = 28;
-	uint8_t home_digit_one_index = 42;
-	uint8_t d1 = guestpoints / 10;  
-	uint8_t d0 = guestpoints % 10; 
-	uint8_t d3 = homepoints / 10; 
-	uint8_t d2 = homepoints % 10;  
-	uint8_t i = 0;
-
-	for(i = 0; i < RGB_LEDS_PER_DIGIT; i++)
+	if(IS_ENABLED(CONFIG_SCOREBOARD_PAWR) && pawr_synced())
 	{
-		if((numbers[d0] & 1 << i) == 1 << i)
-		{
-	  		memcpy(&pixels[i + guest_digit_zero_index], &colors[0], sizeof(struct led_rgb));
-        }
-        else
-        {
-	  		memcpy(&pixels[i + guest_digit_zero_index], &black, sizeof(struct led_rgb));	
-		}
+		return k_uptime_ticks() + k_ms_to_ticks_ceil64(SCORE_HOLD_MS);
 	}
 
-	for(i = 0; i < RGB_LEDS_PER_DIGIT; i++)
-	{
-		if((numbers[d1] & 1 << i) == 1 << i)
-		{
-			memcpy(&pixels[i + guest_digit_one_index], &colors[0], sizeof(struct led_rgb));
-		}
-		else
-		{
-			memcpy(&pixels[i + guest_digit_one_index], &black, sizeof(struct led_rgb));
-		}
-	}	
+	return 0;
+}
 
-	for(i = 0; i < RGB_LEDS_PER_DIGIT; i++)
+/* Ask the render thread for a change at its next frame tick */
+static void render_request(enum render_req_bit bit)
+{
+	struct render_req *req;
+
+	if(zbus_chan_claim(&render_req_chan, K_FOREVER) != 0)
 	{
-		if((numbers[d2] & 1 << i) == 1 << i)
-		{
-	  		memcpy(&pixels[i + home_digit_zero_index], &colors[0], sizeof(struct led_rgb));
-        }
-        else
-        {
-	  		memcpy(&pixels[i + home_digit_zero_index], &black, sizeof(struct led_rgb));	
-		}
+		return;
 	}
+	req = zbus_chan_msg(&render_req_chan);
+	req->pending |= BIT(bit);
+	(void)zbus_chan_finish(&render_req_chan);
+
+	(void)sb_chan_notify(&render_req_chan, K_FOREVER);
+}
 
-	for(i = 0; i < RGB_LEDS_PER_DIGIT; i++)
+/* The changes requested since the last frame, cleared */
+static uint32_t render_take(void)
+{
+	struct render_req *req;
+	uint32_t pending;
+
+	if(zbus_chan_claim(&render_req_chan, K_FOREVER) != 0)
 	{
-		if((numbers[d3] & 1 << i) == 1 << i)
-		{
-			memcpy(&pixels[i + home_digit_one_index], &colors[0], sizeof(struct led_rgb));
-		}
-		else
-		{
-			memcpy(&pixels[i + home_digit_one_index], &black, sizeof(struct led_rgb));
-		}
+		return 0;
 	}
+	req = zbus_chan_msg(&render_req_chan);
+	pending = req->pending;
+	req->pending = 0;
+	(void)zbus_chan_finish(&render_req_chan);
 
-	led_strip_update_rgb(strip, pixels, STRIP_NUM_PIXELS);
+	return pending;
 }
 
-void update_serving(uint8_t serving)
+/* A score from advertising, a GATT notification or a PAwR subevent, the
+ * first one of a change requests RENDER_SCORE and the others find it stale
+ */
+static void score_received(const uint8_t *data, uint16_t len, enum score_path path,
+			   uint16_t seq, int64_t apply_ticks)
 {
-	if((serving & TEAM_HOME_SERVING_BIT) == TEAM_HOME_SERVING_BIT)
+	int64_t now_ms = k_uptime_get();
+	struct score_state *state;
+	int cmp, fresh;
+
+	if(zbus_chan_claim(&score_chan, K_FOREVER) != 0)
+	{
+		return;
+	}
+	state = zbus_chan_msg(&score_chan);
+
+	fresh = memcmp(&state->score, data, MIN(len, MAN_LEN));
+	(void)memcpy(&state->score, data, MIN(len, MAN_LEN));
+	cmp = memcmp(&state->shown, &state->score, MAN_LEN);
+	if(path == SCORE_PAWR)
 	{
-		memcpy(&pixels[56], &colors[0], sizeof(struct led_rgb));		
-		memcpy(&pixels[57], &colors[0], sizeof(struct led_rgb));		
-		memcpy(&pixels[58], &black, sizeof(struct led_rgb));		
-		memcpy(&pixels[59], &black, sizeof(struct led_rgb));		
+		state->seq = seq;
 	}
-	else if((serving & TEAM_GUEST_SERVING_BIT) == TEAM_GUEST_SERVING_BIT)
+
+	/* Every PAwR event carrying the score gives an apply time, which is
+	 * late by the delivery delay, the earliest is the closest
+	 */
+	if(fresh != 0)
 	{
-		memcpy(&pixels[56], &black, sizeof(struct led_rgb));		
-		memcpy(&pixels[57], &black, sizeof(struct led_rgb));		
-		memcpy(&pixels[58], &colors[0], sizeof(struct led_rgb));		
-		memcpy(&pixels[59], &colors[0], sizeof(struct led_rgb));		
+		state->apply_pawr = (path == SCORE_PAWR);
+		state->apply_ticks = apply_ticks;
 	}
-	else if(serving == 0)
+	else if(path == SCORE_PAWR)
 	{
-		memcpy(&pixels[56], &black, sizeof(struct led_rgb));		
-		memcpy(&pixels[57], &black, sizeof(struct led_rgb));		
-		memcpy(&pixels[58], &black, sizeof(struct led_rgb));		
-		memcpy(&pixels[59], &black, sizeof(struct led_rgb));		
+		state->apply_ticks = state->apply_pawr ? MIN(state->apply_ticks, apply_ticks) :
+							 apply_ticks;
+		state->apply_pawr = true;
 	}
 
-	led_strip_update_rgb(strip, pixels, STRIP_NUM_PIXELS);
-}
-
-void update_sets(uint8_t homesets, uint8_t guestsets)
-{
-	uint8_t guest_digit_index = 60;
-	uint8_t home_digit_index = 74;
-	uint8_t i = 0;
-
-	for(i = 0; i < RGB_LEDS_PER_DIGIT; i++)
+	if(IS_ENABLED(CONFIG_SCOREBOARD_GATT))
 	{
-		if((numbers[guestsets] & 1 << i) == 1 << i)
+		if(fresh != 0)
+		{
+			score_rx_ms = now_ms;
+			score_rx_gatt = (path == SCORE_GATT);
+			score_rx_open = true;
+			if((path == SCORE_ADV) && central_subscribed())
+			{
+				STATS_INC(adv_first);
+			}
+		}
+		else if(score_rx_open && score_rx_gatt && (path == SCORE_ADV))
 		{
-	  		memcpy(&pixels[i + guest_digit_index], &colors[0], sizeof(struct led_rgb));
-        }
-        else
-        {
-	  		memcpy(&pixels[i + guest_digit_index], &black, sizeof(struct led_rgb));	
+			/* Advertising caught up with the notification */
+			score_rx_open = false;
+			STATS_HIST(gatt_lead_ms, (uint32_t)(now_ms - score_rx_ms));
 		}
 	}
+	(void)zbus_chan_finish(&score_chan);
 
-	for(i = 0; i < RGB_LEDS_PER_DIGIT; i++)
+	if(fresh != 0)
 	{
-		if((numbers[homesets] & 1 << i) == 1 << i)
-		{
-	  		memcpy(&pixels[i + home_digit_index], &colors[0], sizeof(struct led_rgb));
-        }
-        else
-        {
-	  		memcpy(&pixels[i + home_digit_index], &black, sizeof(struct led_rgb));	
-		}
+		(void)sb_chan_notify(&score_chan, SCORE_NOTIFY_TIMEOUT);
+	}
+
+	if(cmp != 0)
+	{
+		render_request(RENDER_SCORE);
+	}
+	else if(path == SCORE_PAWR)
+	{
+		/* Repeated in every periodic event, already shown */
+		pawr_rendered(seq);
 	}
+	else
+	{
+		STATS_INC(stale_drops);
+	}
+}
 
-	led_strip_update_rgb(strip, pixels, STRIP_NUM_PIXELS);
+static void gatt_score_cb(const uint8_t *data, uint16_t len)
+{
+	STATS_INC(gatt_reports);
+	score_received(data, len, SCORE_GATT, 0, hold_ticks());
+}
+
+static void pawr_score_cb(const uint8_t *data, uint16_t len, uint16_t seq, int64_t apply_ticks)
+{
+	score_received(data, len, SCORE_PAWR, seq, apply_ticks);
 }
 
 static bool data_cb(struct bt_data *data, void *user_data)
 {
+	struct scan_report *report = user_data;
+	const struct bt_le_scan_recv_info *info = report->info;
+	uint8_t sid = info->sid;
 	uint8_t len;
-	int cmp, res = 0;
+	int res = 0;
 
 	switch (data->type) 
 	{
@@ -210,7 +233,7 @@ static bool data_cb(struct bt_data *data, void *user_data)
 			bt_device_name[len] = '\0';
 			if(res == 0)
 			{
-				bt_device_found = true;				
+				report->name_found = true;
 				return true;				
 			}
 			else
@@ -220,17 +243,37 @@ static bool data_cb(struct bt_data *data, void *user_data)
 
 		case BT_DATA_MANUFACTURER_DATA:
 
-			if(bt_device_found == true)
+			SB_TRACE_BEGIN(SB_TRACE_DATA_CB, sid);
+			if(report->name_found && sim_lost)
+			{
+				report->name_found = false;
+				if(sid != SB_ADV_SID_MATCH)
+				{
+					history_score_lost(data->data, data->data_len);
+				}
+			}
+			else if(report->name_found && (sid == SB_ADV_SID_MATCH))
 			{
-				bt_device_found = false;
-				(void)memcpy(bt_man_data, data->data, data->data_len);
-				cmp = memcmp(bt_man_data_curr, bt_man_data, MAN_LEN);
-				if(cmp != 0)
+				report->name_found = false;
+				if(match_record_parse(data->data, data->data_len))
 				{
-					k_sem_give(&sem);
+					STATS_INC(match_records);
+					render_request(RENDER_MATCH);
 				}
-				
 			}
+			else if(report->name_found)
+			{
+				report->name_found = false;
+				STATS_INC(matched_reports);
+				phy_score_report(info);
+				if(relay_score_accept(data->data, data->data_len))
+				{
+					history_score_received(data->data, data->data_len);
+					score_received(data->data, data->data_len, SCORE_ADV, 0,
+						       hold_ticks());
+				}
+			}
+			SB_TRACE_END(SB_TRACE_DATA_CB, sid);
 			return false;	
 
 		default:
@@ -239,74 +282,204 @@ static bool data_cb(struct bt_data *data, void *user_data)
 }
 
 
-static void device_found(const bt_addr_le_t *addr, int8_t rssi, uint8_t type,
-			 struct net_buf_simple *ad)
+static void scan_recv(const struct bt_le_scan_recv_info *info,
+		      struct net_buf_simple *ad)
 {
-	bt_data_parse(ad, data_cb, NULL);	
+	uint8_t sid = info->sid;
+	struct scan_report report = { .info = info };
+
+	/* The legacy score set is for observers without extended scanning */
+	if(!(info->adv_props & BT_GAP_ADV_PROP_EXT_ADV))
+	{
+		return;
+	}
+
+	/* The connectable set is for central.c, the PAwR set for pawr.c, the
+	 * score replicas are for peer broadcasters
+	 */
+	if((sid == SB_ADV_SID_GATT) || (sid == SB_ADV_SID_PAWR) || (sid == SB_ADV_SID_CRDT))
+	{
+		return;
+	}
+
+	SB_TRACE_BEGIN(SB_TRACE_SCAN_RECV, sid);
+	STATS_INC(scan_reports);
+	sim_lost = (CONFIG_SCOREBOARD_SIM_LOSS_PCT > 0) &&
+		   ((sys_rand32_get() % 100) < CONFIG_SCOREBOARD_SIM_LOSS_PCT);
+	bt_data_parse(ad, data_cb, &report);
+	SB_TRACE_END(SB_TRACE_SCAN_RECV, sid);
 }
 
+static struct bt_le_scan_cb scan_callbacks = {
+	.recv = scan_recv,
+};
+
+
 
 int thread0(void)
 {
 	int err;
+	bool score_pending = false;
 	
-	struct bt_le_scan_param scan_param = {
+	/* With extended scanning the controller duplicate filter also compares
+	 * the ADI, so repeats of the same score are dropped in the controller
+	 * while a new score (new DID) is still reported to the host. The PER
+	 * measurement and the simulated loss need every repeat and a
+	 * continuous scan instead.
+	 */
+	static const struct bt_le_scan_param scan_param = {
 		.type       = BT_LE_SCAN_TYPE_ACTIVE,
-		.options    = BT_LE_SCAN_OPT_FILTER_DUPLICATE,
+		.options    = (SCAN_ALL_REPORTS ? 0 : BT_LE_SCAN_OPT_FILTER_DUPLICATE) |
+			      (IS_ENABLED(CONFIG_SCOREBOARD_SCAN_CODED) ?
+			       BT_LE_SCAN_OPT_CODED : 0),
 		.interval   = BT_GAP_SCAN_FAST_INTERVAL,
-		.window     = BT_GAP_SCAN_FAST_WINDOW,
+		.window     = SCAN_ALL_REPORTS ?
+			      BT_GAP_SCAN_FAST_INTERVAL : BT_GAP_SCAN_FAST_WINDOW,
 	};
 
-	printk("Starting Observer Demo\n");
+	LOG_INF("Starting Observer Demo");
 
 	/* Initialize the Bluetooth Subsystem */
 	err = bt_enable(NULL);
 	if (err) {
-		printk("Bluetooth init failed (err %d)\n", err);
+		LOG_ERR("Bluetooth init failed (err %d)", err);
 		return 0;
 	}
 
-	err = bt_le_scan_start(&scan_param, device_found);
-	if (err) {
-		printk("Start scanning failed (err %d)\n", err);
-		return err;
+	bt_le_scan_cb_register(&scan_callbacks);
+
+	if(IS_ENABLED(CONFIG_SCOREBOARD_GATT))
+	{
+		central_init(&scan_param, gatt_score_cb);
+	}
+
+	if(IS_ENABLED(CONFIG_SCOREBOARD_PAWR))
+	{
+		pawr_init(&scan_param, pawr_score_cb);
 	}
 
-	if (device_is_ready(strip)) {
-		printk("Found LED strip device %s", strip->name);
-	} else {
-		printk("LED strip device %s is not ready", strip->name);
+	err = relay_init();
+	if (err) {
+		LOG_ERR("Relay init failed (err %d)", err);
 		return 0;
 	}
 
-	memset(&pixels, 0x00, sizeof(pixels));
-	led_strip_update_rgb(strip, pixels, STRIP_NUM_PIXELS);
+	err = bt_le_scan_start(&scan_param, NULL);
+	if (err) {
+		LOG_ERR("Start scanning failed (err %d)", err);
+		return err;
+	}
 
-	update_points(0, 0);
-	update_serving(0);
-	update_sets(0, 0);	
+	err = display_init();
+	if (err) {
+		LOG_ERR("LED strip device is not ready");
+		return 0;
+	}
 
-	printk("Started scanning...\n");
+	LOG_INF("Started scanning...");
 	
 	while(1)
 	{		
-		k_sem_take(&sem, K_FOREVER);
+		/* Updates received since the last frame are applied at the
+		 * frame tick, see display.c
+		 */
+		uint32_t loop_us;
+		uint32_t loop_start_cyc;
+		uint32_t requests;
+		struct sb_score score;
+		const uint8_t *man_data = (const uint8_t *)&score;
+		bool score_applied = false;
+		uint16_t score_seq = 0;
+		int64_t score_apply_ticks = 0;
+		bool score_apply_pawr = false;
+
+		display_frame_wait();
+		loop_start_cyc = k_cycle_get_32();
+		requests = render_take();
+		score_pending |= (requests & BIT(RENDER_SCORE)) != 0;
+
+		/* Deferred logging only packages the arguments here, the
+		 * formatting happens on the host from the dictionary.
+		 */
+		if(requests & BIT(RENDER_MATCH))
+		{
+			struct match_info match_info;
+			const uint8_t *c = match_info.team_colors;
+
+			match_info_get(&match_info);
 
-		printk("Device Name: %s ", bt_device_name);
-		printk("\n");
+			/* A palette change, the digits are not redrawn */
+			display_set_team_colors((struct led_rgb){ .r = c[0], .g = c[1], .b = c[2] },
+						(struct led_rgb){ .r = c[3], .g = c[4], .b = c[5] });
+			display_set_text(LAYOUT_TEXT_HOME_NAME, match_info.home_name);
+			display_set_text(LAYOUT_TEXT_GUEST_NAME, match_info.guest_name);
+			display_set_text(LAYOUT_TEXT_MESSAGE, match_info.message);
 
-		printk("Manufacturer data: ");
-		for (uint16_t i=0; i<MAN_LEN; i++)
+			if(IS_ENABLED(CONFIG_SCOREBOARD_LOG_UPDATES))
+			{
+				int32_t drift_last_ms, drift_max_ms;
+
+				clock_drift_get(&drift_last_ms, &drift_max_ms);
+				LOG_INF("Match: %s vs %s, period %u, timeouts %u/%u, fouls %u/%u",
+					match_info.home_name, match_info.guest_name,
+					match_info.period, match_info.timeouts[0],
+					match_info.timeouts[1], match_info.fouls[0],
+					match_info.fouls[1]);
+				LOG_INF("Clock drift: last %d ms, max %d ms", drift_last_ms, drift_max_ms);
+			}
+		}
+
+		/* A score with an apply time is staged at the last frame tick
+		 * before it and committed at that instant
+		 */
+		if(score_pending && (zbus_chan_claim(&score_chan, K_FOREVER) == 0))
 		{
-			printk("%02x:", bt_man_data[i]);
+			struct score_state *state = zbus_chan_msg(&score_chan);
+
+			score_apply_ticks = state->apply_ticks;
+			if((score_apply_ticks - k_uptime_ticks()) <
+			   k_us_to_ticks_floor64(DISPLAY_FRAME_PERIOD_US))
+			{
+				score_pending = false;
+				score = state->score;
+				state->shown = state->score;
+				score_seq = state->seq;
+				score_apply_pawr = state->apply_pawr;
+				score_applied = true;
+			}
+			(void)zbus_chan_finish(&score_chan);
 		}
-		printk("\n");
 
-		update_points(bt_man_data[2], bt_man_data[3]);		
-		update_sets(bt_man_data[4], bt_man_data[5]);
-		update_serving(bt_man_data[6]);	
+		/* The score is logged by src/score_log.c */
+		if(score_applied)
+		{
+			display_set_points(sys_get_le16(&man_data[offsetof(struct sb_score, home_points)]),
+					   sys_get_le16(&man_data[offsetof(struct sb_score, guest_points)]));
+			display_set_sets(man_data[offsetof(struct sb_score, home_sets)],
+					 man_data[offsetof(struct sb_score, guest_sets)]);
+			display_set_serving(man_data[offsetof(struct sb_score, serving)]);
+
+			if(score_apply_ticks != 0)
+			{
+				display_frame_commit_at(score_apply_ticks);
+			}
+		}
+
+		display_frame_render();
+
+		/* Acknowledged in the next PAwR response slot */
+		if(IS_ENABLED(CONFIG_SCOREBOARD_PAWR) && score_applied)
+		{
+			if(score_apply_pawr)
+			{
+				STATS_HIST(apply_late_us, display_commit_late_us());
+				pawr_apply_late(display_commit_late_us());
+			}
+			pawr_rendered(score_seq);
+		}
 
-		memcpy(bt_man_data_curr, bt_man_data, MAN_LEN);
+		loop_us = k_cyc_to_us_floor32(k_cycle_get_32() - loop_start_cyc);
+		STATS_HIST(render_loop_us, loop_us);
 	}	
 }
 
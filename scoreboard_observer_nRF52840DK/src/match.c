@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/buf.h>
+#include <string.h>
+#include "clock.h"
+#include "match.h"
+
+#define MATCH_INFO_INIT { \
+	.team_colors = { 0xFF, 0x00, 0x00, 0xFF, 0x00, 0x00 }, \
+	.period = 1, \
+}
+
+/* Parsed by the Bluetooth RX thread only, copied to match_info under
+ * match_lock when it changes
+ */
+static struct match_info rx_info = MATCH_INFO_INIT;
+static struct match_info match_info = MATCH_INFO_INIT;
+static struct k_spinlock match_lock;
+
+static bool update_bytes(uint8_t *dst, size_t size, const struct sb_tlv *tlv)
+{
+	if ((tlv->len != size) || (memcmp(dst, tlv->value, size) == 0)) {
+		return false;
+	}
+
+	memcpy(dst, tlv->value, size);
+
+	return true;
+}
+
+static bool update_text(char *dst, size_t max_len, const struct sb_tlv *tlv)
+{
+	uint8_t len = MIN(tlv->len, max_len);
+
+	if ((strlen(dst) == len) && (memcmp(dst, tlv->value, len) == 0)) {
+		return false;
+	}
+
+	memcpy(dst, tlv->value, len);
+	dst[len] = '\0';
+
+	return true;
+}
+
+bool match_record_parse(const uint8_t *data, uint8_t len)
+{
+	struct net_buf_simple buf;
+	struct sb_tlv tlv;
+	bool changed = false;
+
+	/* Company ID and record ID */
+	if ((len < 3) || (data[2] != SB_MATCH_RECORD_ID)) {
+		return false;
+	}
+
+	net_buf_simple_init_with_data(&buf, (void *)data, len);
+	net_buf_simple_pull(&buf, 3);
+
+	while (sb_tlv_next(&buf, &tlv)) {
+		switch (tlv.type) {
+		case SB_TLV_TEAM_HOME_NAME:
+			changed |= update_text(rx_info.home_name, SB_TEAM_NAME_MAX_LEN, &tlv);
+			break;
+		case SB_TLV_TEAM_GUEST_NAME:
+			changed |= update_text(rx_info.guest_name, SB_TEAM_NAME_MAX_LEN, &tlv);
+			break;
+		case SB_TLV_TEAM_COLORS:
+			changed |= update_bytes(rx_info.team_colors,
+						sizeof(rx_info.team_colors), &tlv);
+			break;
+		case SB_TLV_TIMEOUTS:
+			changed |= update_bytes(rx_info.timeouts,
+						sizeof(rx_info.timeouts), &tlv);
+			break;
+		case SB_TLV_FOULS:
+			changed |= update_bytes(rx_info.fouls,
+						sizeof(rx_info.fouls), &tlv);
+			break;
+		case SB_TLV_PERIOD:
+			changed |= update_bytes(&rx_info.period,
+						sizeof(rx_info.period), &tlv);
+			break;
+		case SB_TLV_CLOCK:
+			changed |= clock_anchor_update(&tlv);
+			break;
+		case SB_TLV_MESSAGE:
+			changed |= update_text(rx_info.message, SB_MESSAGE_MAX_LEN, &tlv);
+			break;
+		default:
+			/* Unknown types are skipped for forward compatibility */
+			break;
+		}
+	}
+
+	if (changed) {
+		k_spinlock_key_t key = k_spin_lock(&match_lock);
+
+		match_info = rx_info;
+		k_spin_unlock(&match_lock, key);
+	}
+
+	return changed;
+}
+
+void match_info_get(struct match_info *info)
+{
+	k_spinlock_key_t key = k_spin_lock(&match_lock);
+
+	*info = match_info;
+	k_spin_unlock(&match_lock, key);
+}
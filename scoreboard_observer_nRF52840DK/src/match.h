@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef MATCH_H_
+#define MATCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <scoreboard_proto.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Match record as last received from the broadcaster */
+struct match_info {
+	char home_name[SB_TEAM_NAME_MAX_LEN + 1];
+	char guest_name[SB_TEAM_NAME_MAX_LEN + 1];
+	char message[SB_MESSAGE_MAX_LEN + 1];
+	uint8_t team_colors[6];
+	uint8_t timeouts[2];
+	uint8_t fouls[2];
+	uint8_t period;
+};
+
+/**
+ * @brief Decode a match record manufacturer data field.
+ *
+ * Single pass over the advertising data. Only the fields that differ from
+ * the last record are written, the record itself is never copied.
+ *
+ * @param data Manufacturer data, starting with the company ID.
+ * @param len Length of @p data.
+ *
+ * @return true if the match record changed.
+ */
+bool match_record_parse(const uint8_t *data, uint8_t len);
+
+/**
+ * @brief Copy of the match record as last received.
+ *
+ * Safe to call from any thread while the record is being parsed.
+ *
+ * @param info Receives the match record.
+ */
+void match_info_get(struct match_info *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MATCH_H_ */
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Periodic advertising with responses (PAwR) display side.
+ *
+ * The display syncs to the broadcaster's PAwR set and to both of its
+ * subevents. Every score subevent is answered in the response slot of
+ * CONFIG_SCOREBOARD_DISPLAY_ID, at a fixed offset from the subevent, with
+ * the score sequence last shown. The retry subevent only carries data
+ * while some display lags behind, it is answered the same way.
+ *
+ * A new score is shown at the anchor of the periodic event the subevent
+ * names. The anchor is estimated from the local time the subevent data
+ * arrives, less its subevent offset. The host delivery delay only adds to
+ * that time, so the earliest estimate of all the events carrying the score
+ * is kept, see main.c.
+ *
+ * Sync loss is recovered by the scanner, which keeps running and syncs
+ * again when it sees the set. Advertising keeps updating the score
+ * meanwhile.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <scoreboard_proto.h>
+#include "pawr.h"
+#include "stats.h"
+
+LOG_MODULE_DECLARE(observer, LOG_LEVEL_INF);
+
+#define COMPANY_ID_CODE 0x0059 /* Nordic BLE ID */
+
+/* Sync lost after six periodic intervals without a packet */
+#define SYNC_TIMEOUT_INTERVALS 6
+
+static const struct bt_le_scan_param *scan_param;
+static pawr_score_cb_t score_cb;
+
+/* Written by the BT RX thread only */
+static struct bt_le_per_adv_sync *sync;
+static int64_t interval_ticks;
+static int64_t subevent_interval_ticks;
+
+static atomic_t synced_flag;
+static atomic_t rendered_seq;
+static atomic_t apply_late_us;
+
+NET_BUF_SIMPLE_DEFINE_STATIC(rsp_buf, sizeof(struct sb_pawr_ack));
+
+/* The set is seen again after a restart only, the duplicate filter hides
+ * its unchanged advertising data
+ */
+static void scan_restart(void)
+{
+	int err;
+
+	(void)bt_le_scan_stop();
+	err = bt_le_scan_start(scan_param, NULL);
+	if (err) {
+		LOG_ERR("Restart scanning failed (err %d)", err);
+	}
+}
+
+static void scan_recv(const struct bt_le_scan_recv_info *info, struct net_buf_simple *ad)
+{
+	struct bt_le_per_adv_sync_param param = {
+		.sid = info->sid,
+		.options = 0,
+		.skip = 0,
+	};
+	uint32_t interval_ms;
+	int err;
+
+	if (sync || (info->sid != SB_ADV_SID_PAWR) || (info->interval == 0)) {
+		return;
+	}
+
+	/* Interval in 1.25 ms units, timeout in 10 ms units */
+	interval_ms = info->interval * 5U / 4U;
+	param.timeout = CLAMP(SYNC_TIMEOUT_INTERVALS * interval_ms / 10,
+			      BT_GAP_PER_ADV_MIN_TIMEOUT, BT_GAP_PER_ADV_MAX_TIMEOUT);
+	bt_addr_le_copy(&param.addr, info->addr);
+
+	err = bt_le_per_adv_sync_create(&param, &sync);
+	if (err) {
+		LOG_ERR("PAwR sync create failed (err %d)", err);
+		sync = NULL;
+		scan_restart();
+	}
+}
+
+static struct bt_le_scan_cb scan_callbacks = {
+	.recv = scan_recv,
+};
+
+static void synced(struct bt_le_per_adv_sync *s, struct bt_le_per_adv_sync_synced_info *info)
+{
+	static uint8_t subevents[SB_PAWR_NUM_SUBEVENTS] = {
+		SB_PAWR_SUBEVENT_SCORE,
+		SB_PAWR_SUBEVENT_RETRY,
+	};
+	struct bt_le_per_adv_sync_subevent_params params = {
+		.properties = 0,
+		.num_subevents = ARRAY_SIZE(subevents),
+		.subevents = subevents,
+	};
+	int err;
+
+	/* Both in 1.25 ms units */
+	interval_ticks = k_us_to_ticks_near64(info->interval * 1250U);
+	subevent_interval_ticks = k_us_to_ticks_near64(info->subevent_interval * 1250U);
+
+	err = bt_le_per_adv_sync_subevent(s, &params);
+	if (err) {
+		LOG_ERR("PAwR subevent sync failed (err %d)", err);
+		return;
+	}
+
+	atomic_set(&synced_flag, 1);
+
+	LOG_INF("PAwR synced, slot %u", CONFIG_SCOREBOARD_DISPLAY_ID);
+}
+
+static void term(struct bt_le_per_adv_sync *s, const struct bt_le_per_adv_sync_term_info *info)
+{
+	if (s == sync) {
+		sync = NULL;
+		atomic_clear(&synced_flag);
+		STATS_INC(pawr_sync_losses);
+		scan_restart();
+	}
+}
+
+static void recv(struct bt_le_per_adv_sync *s, const struct bt_le_per_adv_sync_recv_info *info,
+		 struct net_buf_simple *buf)
+{
+	const struct bt_le_per_adv_response_params rsp_params = {
+		.request_event = info->periodic_event_counter,
+		.request_subevent = info->subevent,
+		.response_subevent = info->subevent,
+		.response_slot = CONFIG_SCOREBOARD_DISPLAY_ID,
+	};
+	int64_t rx_ticks = k_uptime_ticks();
+	const struct sb_pawr_score *rx;
+	struct sb_pawr_ack ack;
+	int64_t apply_ticks;
+	int err;
+
+	if (!buf || (buf->len < sizeof(*rx))) {
+		return;
+	}
+
+	rx = (const struct sb_pawr_score *)buf->data;
+	if (sys_le16_to_cpu(rx->score.company_id) != COMPANY_ID_CODE) {
+		return;
+	}
+
+	apply_ticks = rx_ticks - info->subevent * subevent_interval_ticks +
+		      rx->apply_in * interval_ticks;
+
+	STATS_INC(pawr_reports);
+	score_cb((const uint8_t *)&rx->score, sizeof(rx->score), sys_le16_to_cpu(rx->seq),
+		 apply_ticks);
+
+	ack.company_id = sys_cpu_to_le16(COMPANY_ID_CODE);
+	ack.display_id = CONFIG_SCOREBOARD_DISPLAY_ID;
+	ack.seq = sys_cpu_to_le16((uint16_t)atomic_get(&rendered_seq));
+	ack.apply_late_us = sys_cpu_to_le16((uint16_t)atomic_get(&apply_late_us));
+
+	net_buf_simple_reset(&rsp_buf);
+	net_buf_simple_add_mem(&rsp_buf, &ack, sizeof(ack));
+
+	err = bt_le_per_adv_set_response_data(s, &rsp_params, &rsp_buf);
+	if (err) {
+		STATS_INC(pawr_rsp_errors);
+	}
+}
+
+static struct bt_le_per_adv_sync_cb sync_callbacks = {
+	.synced = synced,
+	.term = term,
+	.recv = recv,
+};
+
+void pawr_init(const struct bt_le_scan_param *param, pawr_score_cb_t cb)
+{
+	scan_param = param;
+	score_cb = cb;
+
+	bt_le_per_adv_sync_cb_register(&sync_callbacks);
+	bt_le_scan_cb_register(&scan_callbacks);
+}
+
+bool pawr_synced(void)
+{
+	return atomic_get(&synced_flag) != 0;
+}
+
+void pawr_rendered(uint16_t seq)
+{
+	atomic_set(&rendered_seq, seq);
+}
+
+void pawr_apply_late(uint32_t late_us)
+{
+	atomic_set(&apply_late_us, MIN(late_us, UINT16_MAX));
+}
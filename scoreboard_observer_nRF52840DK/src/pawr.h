@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef PAWR_H_
+#define PAWR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/bluetooth/bluetooth.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief PAwR score callback, called from the Bluetooth RX thread.
+ *
+ * @param data struct sb_score.
+ * @param len Length of @p data.
+ * @param seq Score sequence of the broadcaster.
+ * @param apply_ticks Uptime in ticks at which the score is to be shown.
+ */
+typedef void (*pawr_score_cb_t)(const uint8_t *data, uint16_t len, uint16_t seq,
+				int64_t apply_ticks);
+
+/**
+ * @brief Sync to the broadcaster's PAwR set when it is seen by the scanner.
+ *
+ * Scanning is restarted with @p param when the sync is lost, to see the set
+ * again.
+ *
+ * @param param Scan parameters of the observer, must stay valid.
+ * @param score_cb Called for every score subevent.
+ */
+void pawr_init(const struct bt_le_scan_param *param, pawr_score_cb_t score_cb);
+
+/** @brief true while synced to the PAwR score and retry subevents. */
+bool pawr_synced(void);
+
+/**
+ * @brief Report a score sequence as shown on the display.
+ *
+ * Sent to the broadcaster in the next response slot.
+ */
+void pawr_rendered(uint16_t seq);
+
+/**
+ * @brief Report how late the last score was shown after its apply time.
+ *
+ * Sent to the broadcaster with the sequence, which derives the commit
+ * jitter between displays from it.
+ */
+void pawr_apply_late(uint32_t late_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAWR_H_ */
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Reception by PHY.
+ *
+ * Score reports are counted by their secondary PHY, the one that carried
+ * the data, and their RSSI is compared with the receiver sensitivity on
+ * that PHY. The margin tells how much range is left at the display.
+ *
+ * With CONFIG_SCOREBOARD_PHY_PER the scanner keeps every report, so the
+ * reports of the broadcaster's score set can be compared with the number
+ * of advertising events it sent to get the packet error rate.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/gap.h>
+#include <zephyr/shell/shell.h>
+#include <zephyr/sys/atomic.h>
+#include <scoreboard_proto.h>
+#include "phy.h"
+#include "stats.h"
+
+/* nRF52840 receiver sensitivity, Coded at S8 */
+#define SENSITIVITY_1M_DBM    (-95)
+#define SENSITIVITY_2M_DBM    (-92)
+#define SENSITIVITY_CODED_DBM (-103)
+
+/* The controller delays every advertising event by 0 to 10 ms */
+#define ADV_DELAY_AVG_MS 5
+
+/* Score set reports, BT RX */
+static atomic_t score_set_reports;
+
+void phy_score_report(const struct bt_le_scan_recv_info *info)
+{
+	int sensitivity_dbm;
+
+	switch (info->secondary_phy) {
+	case BT_GAP_LE_PHY_CODED:
+		STATS_INC(score_reports_coded);
+		sensitivity_dbm = SENSITIVITY_CODED_DBM;
+		break;
+	case BT_GAP_LE_PHY_2M:
+		STATS_INC(score_reports_2m);
+		sensitivity_dbm = SENSITIVITY_2M_DBM;
+		break;
+	default:
+		STATS_INC(score_reports_1m);
+		sensitivity_dbm = SENSITIVITY_1M_DBM;
+		break;
+	}
+
+	STATS_HIST(rssi_margin_db, MAX(info->rssi - sensitivity_dbm, 0));
+
+	if (info->sid == SB_ADV_SID_SCORE) {
+		atomic_inc(&score_set_reports);
+	}
+}
+
+#if defined(CONFIG_SCOREBOARD_PHY_PER)
+void phy_per_print(const struct shell *sh)
+{
+	static int64_t start_ms;
+	static atomic_val_t start_reports;
+	int64_t now_ms = k_uptime_get();
+	atomic_val_t reports = atomic_get(&score_set_reports);
+	uint32_t received = reports - start_reports;
+	uint32_t events;
+	uint32_t lost;
+
+	events = (now_ms - start_ms) / (CONFIG_SCOREBOARD_PHY_PER_INTERVAL_MS + ADV_DELAY_AVG_MS);
+	lost = (events > received) ? (events - received) : 0;
+
+	if (start_ms == 0) {
+		shell_print(sh, "measuring, run again for the PER");
+	} else if (events > 0) {
+		shell_print(sh, "%u of %u events received in %u ms, PER %u.%u %%", received,
+			    events, (uint32_t)(now_ms - start_ms), lost * 100 / events,
+			    (lost * 1000 / events) % 10);
+	}
+
+	start_ms = now_ms;
+	start_reports = reports;
+}
+#endif
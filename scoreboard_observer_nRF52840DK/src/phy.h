@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef PHY_H_
+#define PHY_H_
+
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/shell/shell.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Count a scoreboard score report by the PHY it arrived on.
+ *
+ * Called from the Bluetooth RX thread for every score report of the
+ * broadcaster or a relay.
+ *
+ * @param info Scan report info.
+ */
+void phy_score_report(const struct bt_le_scan_recv_info *info);
+
+/**
+ * @brief Print the packet error rate of the broadcaster's score set since
+ * the previous call, with CONFIG_SCOREBOARD_PHY_PER.
+ *
+ * @param sh Shell to print to.
+ */
+void phy_per_print(const struct shell *sh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PHY_H_ */
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Pixel kernels.
+ *
+ * The SIMD versions load 4 bytes into one register. UXTB16 spreads bytes 0
+ * and 2 (and, after a shift, 1 and 3) into two halfwords. Multiplying that by
+ * a weight up to 256 cannot carry into the next halfword, so one MUL scales
+ * two bytes. UQSUB8 does four saturating subtractions at once. Tails shorter
+ * than 4 bytes fall back to the scalar code.
+ */
+
+#include <string.h>
+#include "pixel.h"
+
+#if PIXEL_SIMD
+#include <arm_acle.h>
+#endif
+
+#define EVEN_BYTES 0x00FF00FFu
+#define ODD_BYTES  0xFF00FF00u
+
+void pixel_scale_scalar(uint8_t *buf, size_t len, uint8_t scale)
+{
+	uint16_t s = scale + 1;
+
+	for(size_t i = 0; i < len; i++)
+	{
+		buf[i] = (buf[i] * s) >> 8;
+	}
+}
+
+void pixel_crossfade_scalar(uint8_t *out, const uint8_t *from, const uint8_t *to,
+			    size_t len, uint16_t t)
+{
+	uint16_t w = PIXEL_BLEND_MAX - t;
+
+	for(size_t i = 0; i < len; i++)
+	{
+		out[i] = (from[i] * w + to[i] * t) >> 8;
+	}
+}
+
+void pixel_fade_scalar(uint8_t *buf, size_t len, uint8_t step)
+{
+	for(size_t i = 0; i < len; i++)
+	{
+		buf[i] = (buf[i] > step) ? buf[i] - step : 0;
+	}
+}
+
+#if PIXEL_SIMD
+
+/* Compiles to a single LDR/STR, which may be unaligned on Cortex-M4 */
+static inline uint32_t load32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+static inline void store32(uint8_t *p, uint32_t v)
+{
+	memcpy(p, &v, sizeof(v));
+}
+
+static void pixel_scale_simd(uint8_t *buf, size_t len, uint8_t scale)
+{
+	uint32_t s = scale + 1;
+	size_t i;
+
+	for(i = 0; i + 4 <= len; i += 4)
+	{
+		uint32_t x = load32(&buf[i]);
+		uint32_t even = __uxtb16(x) * s;
+		uint32_t odd = __uxtb16(x >> 8) * s;
+
+		store32(&buf[i], ((even >> 8) & EVEN_BYTES) | (odd & ODD_BYTES));
+	}
+
+	pixel_scale_scalar(&buf[i], len - i, scale);
+}
+
+static void pixel_crossfade_simd(uint8_t *out, const uint8_t *from, const uint8_t *to,
+				 size_t len, uint16_t t)
+{
+	uint32_t w = PIXEL_BLEND_MAX - t;
+	size_t i;
+
+	for(i = 0; i + 4 <= len; i += 4)
+	{
+		uint32_t a = load32(&from[i]);
+		uint32_t b = load32(&to[i]);
+		uint32_t even = __uxtb16(a) * w + __uxtb16(b) * t;
+		uint32_t odd = __uxtb16(a >> 8) * w + __uxtb16(b >> 8) * t;
+
+		store32(&out[i], ((even >> 8) & EVEN_BYTES) | (odd & ODD_BYTES));
+	}
+
+	pixel_crossfade_scalar(&out[i], &from[i], &to[i], len - i, t);
+}
+
+static void pixel_fade_simd(uint8_t *buf, size_t len, uint8_t step)
+{
+	uint32_t steps = step * 0x01010101u;
+	size_t i;
+
+	for(i = 0; i + 4 <= len; i += 4)
+	{
+		store32(&buf[i], __uqsub8(load32(&buf[i]), steps));
+	}
+
+	pixel_fade_scalar(&buf[i], len - i, step);
+}
+
+#endif /* PIXEL_SIMD */
+
+void pixel_scale(uint8_t *buf, size_t len, uint8_t scale)
+{
+#if PIXEL_SIMD
+	pixel_scale_simd(buf, len, scale);
+#else
+	pixel_scale_scalar(buf, len, scale);
+#endif
+}
+
+void pixel_crossfade(uint8_t *out, const uint8_t *from, const uint8_t *to,
+		     size_t len, uint16_t t)
+{
+#if PIXEL_SIMD
+	pixel_crossfade_simd(out, from, to, len, t);
+#else
+	pixel_crossfade_scalar(out, from, to, len, t);
+#endif
+}
+
+void pixel_fade(uint8_t *buf, size_t len, uint8_t step)
+{
+#if PIXEL_SIMD
+	pixel_fade_simd(buf, len, step);
+#else
+	pixel_fade_scalar(buf, len, step);
+#endif
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef PIXEL_H_
+#define PIXEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Kernels over wire format pixels, taken as @p len bytes so that R, G and B
+ * are handled alike. They run 4 bytes at a time with the Cortex-M4 SIMD
+ * instructions when the compiler has them and byte by byte otherwise; both
+ * give the same result. The _scalar variants are always built, for the
+ * comparison.
+ *
+ * Only the benchmark (CONFIG_SCOREBOARD_BENCH) uses them. The display is
+ * palette indexed, so transitions and brightness change a few palette
+ * entries and never a whole frame of pixels.
+ */
+
+#if defined(__ARM_FEATURE_SIMD32)
+#define PIXEL_SIMD 1
+#else
+#define PIXEL_SIMD 0
+#endif
+
+/** Weight of the target in pixel_crossfade() when it is reached */
+#define PIXEL_BLEND_MAX 256
+
+/**
+ * @brief Scale every byte by (@p scale + 1) / 256.
+ *
+ * 255 leaves the pixels unchanged, 0 turns them off.
+ */
+void pixel_scale(uint8_t *buf, size_t len, uint8_t scale);
+
+/**
+ * @brief Blend two frames, out = (from * (256 - t) + to * t) / 256.
+ *
+ * @param t Weight of @p to, 0 to PIXEL_BLEND_MAX.
+ */
+void pixel_crossfade(uint8_t *out, const uint8_t *from, const uint8_t *to,
+		     size_t len, uint16_t t);
+
+/** @brief Fade every byte down by @p step, saturating at 0. */
+void pixel_fade(uint8_t *buf, size_t len, uint8_t step);
+
+void pixel_scale_scalar(uint8_t *buf, size_t len, uint8_t scale);
+void pixel_crossfade_scalar(uint8_t *out, const uint8_t *from, const uint8_t *to,
+			    size_t len, uint16_t t);
+void pixel_fade_scalar(uint8_t *buf, size_t len, uint8_t step);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIXEL_H_ */
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Score relay.
+ *
+ * The broadcaster numbers its score changes within an epoch drawn at each
+ * start. Every observer keeps the newest epoch and sequence it heard and
+ * drops relayed scores that are older, so a slow relay never takes a
+ * display back. The broadcaster itself is always believed.
+ *
+ * A score of another epoch is taken as a restart, and the epoch left is
+ * dropped for EPOCH_HOLD_MS. Relays only keep a score on air while they
+ * hear it from closer to the broadcaster, so scores from before a restart
+ * die out within that time and cannot take a display back for good.
+ *
+ * With CONFIG_SCOREBOARD_RELAY the observer also re-advertises every newer
+ * score on its own set, unchanged but for one more hop. Scores already at
+ * CONFIG_SCOREBOARD_RELAY_MAX_HOPS are not relayed, and a score is relayed
+ * once, so relays hearing each other cannot loop. The re-advertisement
+ * waits a random delay of up to CONFIG_SCOREBOARD_RELAY_JITTER_MS, relays
+ * that heard the same packet do not all update at once. The set stops after
+ * CONFIG_SCOREBOARD_RELAY_EVENTS events and starts again only if the score
+ * was heard with fewer hops in the meantime.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/random/rand32.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <string.h>
+#include <scoreboard_proto.h>
+#include <sb_trace.h>
+#include "relay.h"
+#include "stats.h"
+
+LOG_MODULE_DECLARE(observer, LOG_LEVEL_INF);
+
+/* Relay advertising interval */
+#define RELAY_INTERVAL_MS 100
+
+/* Longest time a relayed score outlives its source: every hop can keep it
+ * for up to two runs of CONFIG_SCOREBOARD_RELAY_EVENTS
+ */
+#define EPOCH_HOLD_MS (2 * CONFIG_SCOREBOARD_RELAY_MAX_HOPS * \
+		       CONFIG_SCOREBOARD_RELAY_EVENTS * RELAY_INTERVAL_MS)
+
+#define BT_DEVICE "Score Board"
+
+/* Newest epoch and sequence heard, and the epoch before it, BT RX thread
+ * only
+ */
+static uint16_t newest_seq;
+static uint8_t newest_epoch;
+static bool newest_valid;
+static uint8_t left_epoch;
+static int64_t left_ms;
+static bool left_valid;
+
+#if defined(CONFIG_SCOREBOARD_RELAY)
+
+static const struct bt_le_adv_param relay_adv_param = {
+	.id = BT_ID_DEFAULT,
+	.sid = SB_ADV_SID_RELAY,
+	.options = BT_LE_ADV_OPT_EXT_ADV,
+	.interval_min = 160, /* 100ms (160*0.625ms) */
+	.interval_max = 161, /* 100.625ms (161*0.625ms) */
+};
+
+static struct bt_le_ext_adv_start_param relay_start_param = {
+	.num_events = CONFIG_SCOREBOARD_RELAY_EVENTS,
+};
+
+/* relay_flags bits */
+enum {
+	RELAY_NEW,    /* relay_pending not on air yet */
+	RELAY_HEARD,  /* Score heard with fewer hops since the set started */
+	RELAY_ACTIVE, /* Set advertising */
+};
+
+/* Score to re-advertise, from the BT RX thread to the work */
+static struct k_spinlock relay_lock;
+static struct sb_score_adv relay_pending;
+static int64_t relay_rx_ms;
+static atomic_t relay_flags;
+
+/* Hops of the score relayed, BT RX thread only */
+static uint8_t relay_hops;
+
+/* Advertising data, system workqueue only */
+static struct sb_score_adv relay_data;
+
+static struct bt_data relay_ad[] = {
+	BT_DATA_BYTES(BT_DATA_FLAGS, BT_LE_AD_NO_BREDR),
+	BT_DATA(BT_DATA_NAME_COMPLETE, BT_DEVICE, sizeof(BT_DEVICE) - 1),
+	BT_DATA(BT_DATA_MANUFACTURER_DATA, &relay_data, sizeof(relay_data)),
+};
+
+static struct bt_le_ext_adv *relay_adv;
+
+static void relay_work_handler(struct k_work *work)
+{
+	bool new_data = atomic_test_and_clear_bit(&relay_flags, RELAY_NEW);
+	k_spinlock_key_t key;
+	int64_t rx_ms;
+	int err = 0;
+
+	if (new_data) {
+		key = k_spin_lock(&relay_lock);
+		relay_data = relay_pending;
+		rx_ms = relay_rx_ms;
+		k_spin_unlock(&relay_lock, key);
+
+		err = bt_le_ext_adv_set_data(relay_adv, relay_ad, ARRAY_SIZE(relay_ad), NULL, 0);
+	}
+
+	/* Runs of the set need the score heard again to be repeated */
+	if (!err && !atomic_test_bit(&relay_flags, RELAY_ACTIVE)) {
+		atomic_clear_bit(&relay_flags, RELAY_HEARD);
+		err = bt_le_ext_adv_start(relay_adv, &relay_start_param);
+		if (!err) {
+			atomic_set_bit(&relay_flags, RELAY_ACTIVE);
+		}
+	}
+
+	if (!new_data) {
+		if (err) {
+			LOG_ERR("Relay restart failed (err %d)", err);
+		}
+		return;
+	}
+
+	SB_TRACE_END(SB_TRACE_RELAY_TX, sys_le16_to_cpu(relay_data.seq));
+
+	if (err) {
+		LOG_ERR("Relay advertising failed (err %d)", err);
+		return;
+	}
+
+	STATS_INC(relayed);
+	STATS_HIST(relay_delay_ms, (uint32_t)(k_uptime_get() - rx_ms));
+}
+
+static K_WORK_DELAYABLE_DEFINE(relay_work, relay_work_handler);
+
+/* The set sent its CONFIG_SCOREBOARD_RELAY_EVENTS events, from the BT RX
+ * thread. It goes on only if the score is still heard from closer.
+ */
+static void relay_sent(struct bt_le_ext_adv *adv, struct bt_le_ext_adv_sent_info *info)
+{
+	atomic_clear_bit(&relay_flags, RELAY_ACTIVE);
+
+	if (atomic_test_and_clear_bit(&relay_flags, RELAY_HEARD)) {
+		k_work_reschedule(&relay_work, K_NO_WAIT);
+	} else {
+		STATS_INC(relay_expired);
+	}
+}
+
+static const struct bt_le_ext_adv_cb relay_adv_cb = {
+	.sent = relay_sent,
+};
+
+static void relay_schedule(const struct sb_score_adv *rx)
+{
+	k_spinlock_key_t key;
+
+	if (rx->hops >= CONFIG_SCOREBOARD_RELAY_MAX_HOPS) {
+		return;
+	}
+
+	key = k_spin_lock(&relay_lock);
+
+	relay_pending = *rx;
+	relay_pending.hops = rx->hops + 1;
+	relay_rx_ms = k_uptime_get();
+	k_spin_unlock(&relay_lock, key);
+
+	relay_hops = rx->hops + 1;
+	atomic_set_bit(&relay_flags, RELAY_NEW);
+
+	/* A newer score while one is waiting keeps the running delay */
+	SB_TRACE_BEGIN(SB_TRACE_RELAY_TX, sys_le16_to_cpu(rx->seq));
+	k_work_schedule(&relay_work,
+			K_MSEC(sys_rand32_get() % (CONFIG_SCOREBOARD_RELAY_JITTER_MS + 1)));
+}
+
+/* The relayed score was heard again */
+static void relay_refresh(const struct sb_score_adv *rx)
+{
+	if (rx->hops < relay_hops) {
+		atomic_set_bit(&relay_flags, RELAY_HEARD);
+	}
+}
+
+int relay_init(void)
+{
+	return bt_le_ext_adv_create(&relay_adv_param, &relay_adv_cb, &relay_adv);
+}
+
+#else
+
+static void relay_schedule(const struct sb_score_adv *rx)
+{
+	ARG_UNUSED(rx);
+}
+
+static void relay_refresh(const struct sb_score_adv *rx)
+{
+	ARG_UNUSED(rx);
+}
+
+int relay_init(void)
+{
+	return 0;
+}
+
+#endif /* CONFIG_SCOREBOARD_RELAY */
+
+bool relay_score_accept(const uint8_t *data, uint8_t len)
+{
+	const struct sb_score_adv *rx = (const struct sb_score_adv *)data;
+	int64_t now_ms = k_uptime_get();
+	uint16_t seq;
+	int16_t age;
+
+	/* A broadcaster without sequence numbers */
+	if (len < sizeof(*rx)) {
+		return true;
+	}
+
+	seq = sys_le16_to_cpu(rx->seq);
+
+	if (newest_valid && (rx->epoch == newest_epoch)) {
+		age = (int16_t)(newest_seq - seq);
+
+		if (age == 0) {
+			relay_refresh(rx);
+			return true;
+		}
+
+		if ((age > 0) && (rx->hops > 0)) {
+			STATS_INC(relay_stale_drops);
+			return false;
+		}
+	} else if (newest_valid) {
+		/* Relayed scores of the epoch just left are from before a
+		 * restart, unless the broadcaster itself sends it
+		 */
+		if (left_valid && (rx->epoch == left_epoch) && (rx->hops > 0) &&
+		    ((now_ms - left_ms) < EPOCH_HOLD_MS)) {
+			STATS_INC(relay_stale_drops);
+			return false;
+		}
+
+		left_epoch = newest_epoch;
+		left_ms = now_ms;
+		left_valid = true;
+		STATS_INC(epoch_changes);
+	}
+
+	SB_TRACE_BEGIN(SB_TRACE_RELAY_RX, rx->hops);
+	newest_seq = seq;
+	newest_epoch = rx->epoch;
+	newest_valid = true;
+	STATS_HIST(score_hops, rx->hops);
+
+	relay_schedule(rx);
+	SB_TRACE_END(SB_TRACE_RELAY_RX, rx->hops);
+
+	return true;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef RELAY_H_
+#define RELAY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the relay advertising set, with CONFIG_SCOREBOARD_RELAY.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int relay_init(void);
+
+/**
+ * @brief Check a score advertised by the broadcaster or a relay.
+ *
+ * A score relayed with an older sequence than the newest one is stale and
+ * must be dropped. A newer one is re-advertised with one more hop when
+ * this observer is a relay. Called from the Bluetooth RX thread.
+ *
+ * @param data Manufacturer data, struct sb_score_adv or struct sb_score.
+ * @param len Length of @p data.
+ *
+ * @return false if the score is stale.
+ */
+bool relay_score_accept(const uint8_t *data, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RELAY_H_ */
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Log of the scores received, from a zbus subscriber.
+ *
+ * The subscriber thread runs below the render thread, so logging never
+ * delays a frame. A subscriber is only told that the channel was published
+ * and reads it when it gets to run, so of a fast burst it logs the newest
+ * score.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/zbus/zbus.h>
+#include "channels.h"
+
+LOG_MODULE_DECLARE(observer, LOG_LEVEL_INF);
+
+#define SCORE_LOG_STACKSIZE 1024
+#define SCORE_LOG_PRIORITY  7
+
+ZBUS_SUBSCRIBER_DEFINE(score_log_sub, 4);
+
+static void score_log_thread(void)
+{
+	const struct zbus_channel *chan;
+	struct score_state state;
+
+	if (zbus_chan_add_obs(&score_chan, &score_log_sub, K_FOREVER) != 0) {
+		LOG_ERR("Score log not attached");
+		return;
+	}
+
+	while (zbus_sub_wait(&score_log_sub, &chan, K_FOREVER) == 0) {
+		if (zbus_chan_read(chan, &state, K_FOREVER) == 0) {
+			LOG_HEXDUMP_INF(&state.score, sizeof(state.score), "Manufacturer data");
+		}
+	}
+}
+
+K_THREAD_DEFINE(score_log_id, SCORE_LOG_STACKSIZE, score_log_thread, NULL, NULL, NULL,
+		SCORE_LOG_PRIORITY, 0, 0);
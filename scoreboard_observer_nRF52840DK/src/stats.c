@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/shell/shell.h>
+#include <stdlib.h>
+#include "display.h"
+#include "phy.h"
+#include "stats.h"
+
+SB_STATS_SHELL_DEFINE(sb);
+
+static int cmd_brightness(const struct shell *sh, size_t argc, char **argv)
+{
+	char *end;
+	unsigned long brightness = strtoul(argv[1], &end, 0);
+
+	if ((*end != '\0') || (brightness > UINT8_MAX)) {
+		shell_error(sh, "brightness is 0 to 255");
+		return -EINVAL;
+	}
+
+	display_set_brightness(brightness);
+
+	return 0;
+}
+
+#if defined(CONFIG_SCOREBOARD_PHY_PER)
+static int cmd_per(const struct shell *sh, size_t argc, char **argv)
+{
+	phy_per_print(sh);
+
+	return 0;
+}
+#endif
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sb_cmds,
+	SB_STATS_SHELL_CMDS(sb),
+	SHELL_CMD_ARG(brightness, NULL, "Global brightness, 0 to 255", cmd_brightness, 2, 0),
+	IF_ENABLED(CONFIG_SCOREBOARD_PHY_PER,
+		   (SHELL_CMD(per, NULL, "Score set packet error rate since the last call",
+			      cmd_per),))
+	SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(sb, &sb_cmds, "Scoreboard observer statistics and settings", NULL);
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 Markel Robregado
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <sb_stats.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Counters, with their single writer */
+#define STATS_COUNTERS(X)                                                      \
+	X(scan_reports)         /* BT RX: scan reports delivered to the host */ \
+	X(matched_reports)      /* BT RX: scoreboard score reports */           \
+	X(score_reports_1m)     /* BT RX: score reports on 1M */                \
+	X(score_reports_2m)     /* BT RX: score reports on 2M */                \
+	X(score_reports_coded)  /* BT RX: score reports on LE Coded */          \
+	X(stale_drops)          /* BT RX: score reports with the shown score */ \
+	X(match_records)        /* BT RX: match record changes */               \
+	X(gatt_reports)         /* BT RX: score notifications */                \
+	X(adv_first)            /* BT RX: scores advertised before notified */  \
+	X(pawr_reports)         /* BT RX: PAwR score subevents */               \
+	X(pawr_rsp_errors)      /* BT RX: PAwR responses not queued */          \
+	X(pawr_sync_losses)     /* BT RX: PAwR syncs terminated */              \
+	X(relay_stale_drops)    /* BT RX: relayed scores behind the newest */   \
+	X(relay_expired)        /* BT RX: relayed scores no longer heard */     \
+	X(epoch_changes)        /* BT RX: broadcaster restarts */               \
+	X(score_gaps)           /* BT RX: score reports after missed changes */ \
+	X(gap_scores_recovered) /* BT RX: missed scores taken from the history */ \
+	X(gap_scores_lost)      /* BT RX: missed scores beyond the history */   \
+	X(relayed)              /* Workqueue: scores re-advertised */           \
+	X(frames)               /* Render: frame ticks */                       \
+	X(renders)              /* Render: frames sent to the strip */          \
+	X(deadline_misses)      /* Render: skipped ticks and late frames */ \
+	X(current_limits)       /* Render: frames scaled to the supply budget */ \
+	X(digits_clamped)       /* Render: numbers too long for their widget */
+
+/* Histograms in the unit of their suffix, written by the render thread
+ * unless noted
+ */
+#define STATS_HISTS(X)                                                         \
+	X(strip_transfer_us)                                                   \
+	X(render_us)                                                           \
+	X(frame_jitter_us)                                                     \
+	X(render_loop_us)                                                      \
+	X(frame_demand_ma)                                                     \
+	X(update_bytes)                                                        \
+	X(strip0_full_us)       /* First strip sent whole */                   \
+	X(strip0_prefix_us)     /* First strip sent a prefix */                \
+	X(rssi_margin_db)       /* BT RX: score RSSI above PHY sensitivity */  \
+	X(gatt_lead_ms)         /* BT RX: notification ahead of advertising */ \
+	X(apply_late_us)        /* Strip update start after the apply time */  \
+	X(score_hops)           /* BT RX: relay hops of each newer score */     \
+	X(converge_ms)          /* BT RX: first lost report to its score */     \
+	X(relay_delay_ms)       /* Workqueue: newer score heard to re-advertised */ \
+	X(score_pub_us)         /* BT RX: score_chan, with its subscribers */  \
+	X(render_req_pub_us)    /* BT RX: render_req_chan */
+
+struct stats {
+	STATS_COUNTERS(SB_STATS_FIELD)
+};
+
+struct stats_hists {
+	STATS_HISTS(SB_STATS_HIST_FIELD)
+};
+
+extern struct stats stats;
+extern struct stats_hists stats_hists;
+
+#define STATS_INC(_counter) sb_stat_inc(&stats._counter)
+#define STATS_HIST(_hist, _val) sb_hist_add(&stats_hists._hist, (_val))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATS_H_ */
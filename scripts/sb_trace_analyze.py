@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2024 Markel Robregado
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Latency analyzer for CTF traces of the scoreboard firmware.
+
+Build either app with -DEXTRA_CONF_FILE=overlay-tracing.conf, run it on
+native_sim, qemu or hardware, then put the captured stream next to Zephyr's
+CTF metadata (zephyr/subsys/tracing/ctf/tsdl/metadata):
+
+    trace/
+        metadata
+        channel0_0
+
+    scripts/sb_trace_analyze.py trace/
+
+The report has four parts:
+
+* per-stage latency percentiles of the instrumentation points in
+  common/sb_trace.h (enter to exit of the same stage),
+* spans between stages, e.g. from the UART callback to the dispatch thread,
+* ISR durations,
+* per-thread run time and preemptions, plus an optional timeline CSV.
+
+Spans are written as FROM:EDGE,TO:EDGE, with EDGE enter or exit, and measure
+from each FROM event to the next TO event.
+"""
+
+import argparse
+import collections
+import csv
+import sys
+
+try:
+    import bt2
+except ImportError:
+    sys.exit("Missing babeltrace2 Python bindings (python3-bt2)")
+
+ENTER = 0
+EXIT = 1
+
+DEFAULT_SPANS = [
+    # Broadcaster: voice frame to dispatch thread, dispatch to new adv data
+    "uart_cb:exit,dispatch:enter",
+    "dispatch:enter,adv_update:exit",
+    "dispatch:enter,gatt_notify:exit",
+    # Observer: score report to the strip transfer
+    "data_cb:exit,strip_update:enter",
+    "scan_recv:enter,strip_update:exit",
+    "gatt_rx:exit,strip_update:enter",
+    # Relay: newer score heard to re-advertised, jitter included
+    "relay_rx:enter,relay_tx:exit",
+]
+
+PERCENTILES = (50, 90, 99)
+
+
+def field_str(field):
+    """CTF bounded strings arrive as strings or arrays of chars."""
+    try:
+        return str(field).rstrip("\0")
+    except TypeError:
+        return "".join(chr(c) for c in field if c).rstrip("\0")
+
+
+def percentile(values, pct):
+    """Nearest-rank percentile of a sorted list."""
+    if not values:
+        return 0
+    rank = max(1, -(-pct * len(values) // 100))
+    return values[rank - 1]
+
+
+def summary(values_ns):
+    values = sorted(values_ns)
+    stats = [len(values)]
+    stats += [percentile(values, p) / 1000 for p in PERCENTILES]
+    stats.append(values[-1] / 1000 if values else 0)
+    return stats
+
+
+def print_table(title, rows):
+    print(title)
+    header = ["name", "count"] + [f"p{p} us" for p in PERCENTILES] + ["max us"]
+    print("  {:<36} {:>7} {:>10} {:>10} {:>10} {:>10}".format(*header))
+    for name, values in sorted(rows.items()):
+        count, *lat = summary(values)
+        print("  {:<36} {:>7} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}".format(
+            name, count, *lat))
+    print()
+
+
+class Analyzer:
+    def __init__(self, spans):
+        self.spans = [self.parse_span(s) for s in spans]
+        self.span_start = {}
+        self.span_lat = collections.defaultdict(list)
+        self.stage_open = collections.defaultdict(list)
+        self.stage_lat = collections.defaultdict(list)
+        self.isr_open = []
+        self.isr_lat = []
+        self.thread = None
+        self.thread_in_ts = None
+        self.thread_run = collections.defaultdict(int)
+        self.thread_switches = collections.Counter()
+        self.preempted = collections.Counter()
+        self.timeline = []
+
+    @staticmethod
+    def parse_span(text):
+        edges = []
+        for part in text.split(","):
+            stage, edge = part.split(":")
+            edges.append((stage, ENTER if edge == "enter" else EXIT))
+        return tuple(edges)
+
+    def context(self):
+        return "isr" if self.isr_open else (self.thread or "?")
+
+    def on_named_event(self, ts, stage, edge):
+        key = (stage, self.context())
+        if edge == ENTER:
+            self.stage_open[key].append(ts)
+        elif self.stage_open[key]:
+            self.stage_lat[f"{stage} [{key[1]}]"].append(ts - self.stage_open[key].pop())
+
+        for span in self.spans:
+            start, end = span
+            if (stage, edge) == start:
+                self.span_start[span] = ts
+            elif (stage, edge) == end and span in self.span_start:
+                self.span_lat["{}:{} -> {}:{}".format(
+                    start[0], "enter" if start[1] == ENTER else "exit",
+                    end[0], "enter" if end[1] == ENTER else "exit")].append(
+                        ts - self.span_start.pop(span))
+
+    def on_switch_in(self, ts, name):
+        self.thread = name
+        self.thread_in_ts = ts
+        self.thread_switches[name] += 1
+
+    def on_switch_out(self, ts, name):
+        if self.thread_in_ts is not None:
+            self.thread_run[name] += ts - self.thread_in_ts
+            self.timeline.append((self.thread_in_ts, ts, name))
+        # A thread leaving with an open stage was preempted inside it
+        for (stage, ctx), opened in self.stage_open.items():
+            if ctx == name and opened:
+                self.preempted[f"{stage} [{name}]"] += 1
+        self.thread = None
+        self.thread_in_ts = None
+
+    def run(self, path):
+        first_ts = None
+        last_ts = None
+        for msg in bt2.TraceCollectionMessageIterator(path):
+            if type(msg) is not bt2._EventMessageConst:
+                continue
+            ts = msg.default_clock_snapshot.ns_from_origin
+            first_ts = ts if first_ts is None else first_ts
+            last_ts = ts
+            event = msg.event
+            payload = event.payload_field
+
+            if event.name == "named_event":
+                self.on_named_event(ts, field_str(payload["name"]),
+                                    int(payload["arg0"]))
+            elif event.name == "isr_enter":
+                self.isr_open.append(ts)
+            elif event.name == "isr_exit" and self.isr_open:
+                self.isr_lat.append(ts - self.isr_open.pop())
+            elif event.name == "thread_switched_in":
+                self.on_switch_in(ts, field_str(payload["name"]) or
+                                  hex(int(payload["thread_id"])))
+            elif event.name == "thread_switched_out":
+                self.on_switch_out(ts, field_str(payload["name"]) or
+                                   hex(int(payload["thread_id"])))
+
+        return first_ts, last_ts
+
+    def report(self, first_ts, last_ts):
+        print_table("Stage latency (enter to exit)", self.stage_lat)
+        print_table("Spans", self.span_lat)
+        print_table("ISR duration", {"isr": self.isr_lat})
+
+        total = (last_ts - first_ts) if first_ts is not None else 0
+        print("Threads")
+        print("  {:<24} {:>12} {:>8} {:>10}".format("name", "run us", "cpu %", "switches"))
+        for name, run in sorted(self.thread_run.items(), key=lambda i: -i[1]):
+            print("  {:<24} {:>12.1f} {:>8.2f} {:>10}".format(
+                name, run / 1000, 100 * run / total if total else 0,
+                self.thread_switches[name]))
+        print()
+
+        if self.preempted:
+            print("Preempted inside a stage")
+            for name, count in sorted(self.preempted.items()):
+                print(f"  {name:<36} {count:>7}")
+            print()
+
+    def write_timeline(self, path):
+        with open(path, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(["start_ns", "end_ns", "thread"])
+            writer.writerows(self.timeline)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("trace", help="CTF trace directory (metadata and stream)")
+    parser.add_argument("--span", action="append",
+                        help="Span FROM:EDGE,TO:EDGE, may be repeated "
+                             "(default: the scoreboard pipeline spans)")
+    parser.add_argument("--timeline", metavar="CSV",
+                        help="Write the thread run timeline to a CSV file")
+    args = parser.parse_args()
+
+    analyzer = Analyzer(args.span or DEFAULT_SPANS)
+    first_ts, last_ts = analyzer.run(args.trace)
+    analyzer.report(first_ts, last_ts)
+
+    if args.timeline:
+        analyzer.write_timeline(args.timeline)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())